@@ -0,0 +1,229 @@
+#ifndef MOMU_AGGREGATE_SKIP_LIST_H
+#define MOMU_AGGREGATE_SKIP_LIST_H
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace momu {
+namespace skip_list {
+
+// A monoid provides type, identity(), lift(value) and an associative
+// combine(a, b); combine is always applied in key order.
+template <typename V>
+struct SumMonoid {
+    using type = V;
+    static type identity() { return V{}; }
+    static type lift(const V& value) { return value; }
+    static type combine(const type& a, const type& b) { return a + b; }
+};
+
+template <typename V>
+struct MinMonoid {
+    using type = V;
+    static type identity() { return std::numeric_limits<V>::max(); }
+    static type lift(const V& value) { return value; }
+    static type combine(const type& a, const type& b) { return b < a ? b : a; }
+};
+
+template <typename V>
+struct MaxMonoid {
+    using type = V;
+    static type identity() { return std::numeric_limits<V>::lowest(); }
+    static type lift(const V& value) { return value; }
+    static type combine(const type& a, const type& b) { return a < b ? b : a; }
+};
+
+template <typename V>
+struct CountMonoid {
+    using type = size_t;
+    static type identity() { return 0; }
+    static type lift(const V&) { return 1; }
+    static type combine(const type& a, const type& b) { return a + b; }
+};
+
+// summary_[i] combines the values of the nodes in (this, forward_[i]].
+template <typename K, typename V, typename S>
+struct AggregateNode {
+    AggregateNode() = default;
+    AggregateNode(const K& key, const V& value, uint8_t level)
+        : key_(key), value_(value), forward_(level + 1), summary_(level + 1) {}
+
+    AggregateNode(const AggregateNode&) = delete;
+    AggregateNode& operator=(const AggregateNode&) = delete;
+
+    K key_;
+    V value_;
+    std::vector<std::shared_ptr<AggregateNode<K, V, S>>> forward_;
+    std::vector<S> summary_;
+};
+
+template <typename K, typename V, typename Monoid = SumMonoid<V>>
+class AggregateSkipList {
+   public:
+    using Summary = typename Monoid::type;
+
+    explicit AggregateSkipList(uint8_t max_level,
+                               unsigned int seed = std::random_device{}())
+        : max_level_(max_level),
+          header_(std::make_unique<NodeT>(K{}, V{}, max_level_)),
+          gen_(seed),
+          distribution_(0.5) {}
+
+    AggregateSkipList(const AggregateSkipList&) = delete;
+    AggregateSkipList& operator=(const AggregateSkipList&) = delete;
+
+    void put(const K& key, const V& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto preds = find_predecessors(key);
+        auto* node = get_node_at_level_zero(preds[0], key);
+        if (node)
+            node->value_ = value;
+        else
+            node = insert_new_node(key, value, preds);
+        refresh_spans(preds, node);
+    }
+
+    std::optional<V> get(const K& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto preds = find_predecessors(key);
+        if (auto* node = get_node_at_level_zero(preds[0], key)) return node->value_;
+        return std::nullopt;
+    }
+
+    bool contains(const K& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto preds = find_predecessors(key);
+        return get_node_at_level_zero(preds[0], key) != nullptr;
+    }
+
+    bool remove(const K& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto preds = find_predecessors(key);
+        auto* victim = get_node_at_level_zero(preds[0], key);
+        if (!victim) return false;
+
+        delete_node(victim, preds);
+        adjust_max_level();
+        refresh_spans(preds, nullptr);
+        return true;
+    }
+
+    // Combines the values of all keys in [from, to). From the predecessor
+    // of from, every step takes the tallest link that stays below to, so
+    // the walk climbs and then descends the towers in O(log n) hops.
+    Summary aggregate(const K& from, const K& to) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Summary result = Monoid::identity();
+        NodeT* cur = find_predecessors(from)[0];
+        while (true) {
+            int lvl = std::min<int>(cur->forward_.size() - 1, current_max_level_);
+            while (lvl >= 0 && !(cur->forward_[lvl] && cur->forward_[lvl]->key_ < to))
+                --lvl;
+            if (lvl < 0) break;
+            result = Monoid::combine(result, cur->summary_[lvl]);
+            cur = cur->forward_[lvl].get();
+        }
+        return result;
+    }
+
+    size_t size() const { return element_count_; }
+    bool empty() const { return element_count_ == 0; }
+
+   private:
+    using NodeT = AggregateNode<K, V, Summary>;
+    using PredVec = std::vector<NodeT*>;
+
+    PredVec find_predecessors(const K& key) {
+        PredVec preds(max_level_ + 1, nullptr);
+        NodeT* cur = header_.get();
+        for (int i = current_max_level_; i >= 0; --i) {
+            while (cur->forward_[i] && cur->forward_[i]->key_ < key)
+                cur = cur->forward_[i].get();
+            preds[i] = cur;
+        }
+        return preds;
+    }
+
+    NodeT* get_node_at_level_zero(NodeT* pred, const K& key) {
+        auto* nxt = pred->forward_[0].get();
+        return (nxt && nxt->key_ == key) ? nxt : nullptr;
+    }
+
+    NodeT* insert_new_node(const K& key, const V& value, PredVec& preds) {
+        uint8_t lvl = generate_random_level();
+        if (lvl > current_max_level_) {
+            for (uint8_t i = current_max_level_ + 1; i <= lvl; ++i)
+                preds[i] = header_.get();
+            current_max_level_ = lvl;
+        }
+
+        auto node = std::make_shared<NodeT>(key, value, lvl);
+        for (uint8_t i = 0; i <= lvl; ++i) {
+            node->forward_[i] = preds[i]->forward_[i];
+            preds[i]->forward_[i] = node;
+        }
+        ++element_count_;
+        return node.get();
+    }
+
+    void delete_node(NodeT* node, const PredVec& preds) {
+        for (uint8_t i = 0; i <= current_max_level_; ++i) {
+            if (preds[i]->forward_[i].get() == node)
+                preds[i]->forward_[i] = node->forward_[i];
+        }
+        --element_count_;
+    }
+
+    void refresh_spans(const PredVec& preds, NodeT* node) {
+        for (int i = 0; i <= current_max_level_; ++i) {
+            if (node && i < static_cast<int>(node->forward_.size()))
+                recompute_span(node, i);
+            recompute_span(preds[i], i);
+        }
+    }
+
+    void recompute_span(NodeT* x, int lvl) {
+        auto* y = x->forward_[lvl].get();
+        if (!y) return;
+        if (lvl == 0) {
+            x->summary_[0] = Monoid::lift(y->value_);
+            return;
+        }
+        Summary acc = x->summary_[lvl - 1];
+        for (auto* z = x->forward_[lvl - 1].get(); z != y;
+             z = z->forward_[lvl - 1].get())
+            acc = Monoid::combine(acc, z->summary_[lvl - 1]);
+        x->summary_[lvl] = acc;
+    }
+
+    void adjust_max_level() {
+        while (current_max_level_ > 0 && !header_->forward_[current_max_level_])
+            --current_max_level_;
+    }
+
+    uint8_t generate_random_level() {
+        uint8_t lvl = 0;
+        while (distribution_(gen_) && lvl < max_level_) ++lvl;
+        return lvl;
+    }
+
+    uint8_t max_level_;
+    uint8_t current_max_level_{0};
+    std::unique_ptr<NodeT> header_;
+    size_t element_count_{0};
+
+    mutable std::mutex mutex_;
+    std::mt19937 gen_;
+    std::bernoulli_distribution distribution_;
+};
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_AGGREGATE_SKIP_LIST_H
@@ -0,0 +1,443 @@
+// Benchmarks for SkipList, one mode per question:
+//
+//     skip_list_bench ops [entries]
+//         Time and hardware counters per operation type, one row each.
+//         Counters the kernel refuses (perf_event_paranoid above 2, or a
+//         VM without a PMU) are shown as "-".
+//
+//     skip_list_bench memory [entries]
+//         Bytes per entry after a bulk load of SkipList, std::map,
+//         std::unordered_map and a sorted vector, for several key and value
+//         types, and the peak during the load. Heap bytes come from
+//         replacing operator new and delete, so they include what keys and
+//         values allocate themselves; RSS deltas are read from /proc.
+//
+//     skip_list_bench radix [entries]
+//         contains on hits and misses with the radix head off and at several
+//         bit widths, for dense and for random keys. Exits with status 1 if
+//         any width is more than 50% slower than the plain search, so the
+//         smoke run guards against the accelerator turning into a slowdown.
+//
+//     skip_list_bench latency [threads] [ops_per_second] [seconds]
+//         Open-loop latency of a mixed load (80% get, 10% put, 10% remove)
+//         on a preloaded list, corrected for coordinated omission and
+//         reported from p50 to p99.99. It runs once on one thread and once
+//         on the given number of threads at the same total rate, so the
+//         queueing on the list's mutex shows up as the difference in the
+//         tail. Pick a rate one thread can sustain, or both runs measure
+//         an ever-growing backlog instead.
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "latency.h"
+#include "perf_counters.h"
+#include "skip_list.h"
+
+namespace {
+
+using momu::skip_list::LatencyHistogram;
+using momu::skip_list::PerfCounters;
+using momu::skip_list::PerfReport;
+using momu::skip_list::SkipList;
+using Clock = std::chrono::steady_clock;
+
+constexpr uint8_t kMaxLevel = 24;
+
+// Keeps results alive so the measured loops are not optimized away.
+volatile uint64_t sink;
+
+// entries distinct even keys in random order; odd keys are never present.
+std::vector<uint64_t> shuffled_keys(size_t entries, unsigned seed) {
+    std::vector<uint64_t> keys(entries);
+    std::iota(keys.begin(), keys.end(), uint64_t{0});
+    for (auto& key : keys) key *= 2;
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(seed));
+    return keys;
+}
+
+void bench_ops(size_t entries) {
+    auto keys = shuffled_keys(entries, 1);
+    SkipList<uint64_t, uint64_t> list(kMaxLevel, 1);
+    PerfCounters counters;
+    PerfReport report;
+
+    auto measure = [&](const char* op, size_t ops, auto&& fn) {
+        auto start = Clock::now();
+        auto sample = counters.measure(fn);
+        report.add(op, sample, ops, Clock::now() - start);
+    };
+
+    measure("insert", keys.size(), [&] {
+        for (uint64_t key : keys) list.put(key, key);
+    });
+    measure("update", keys.size(), [&] {
+        for (uint64_t key : keys) list.put(key, key + 1);
+    });
+    measure("get_hit", keys.size(), [&] {
+        uint64_t sum = 0;
+        for (uint64_t key : keys) sum += *list.get(key);
+        sink = sum;
+    });
+    measure("get_miss", keys.size(), [&] {
+        uint64_t found = 0;
+        for (uint64_t key : keys) found += list.get(key + 1).has_value();
+        sink = found;
+    });
+    measure("contains", keys.size(), [&] {
+        uint64_t found = 0;
+        for (uint64_t key : keys) found += list.contains(key);
+        sink = found;
+    });
+    size_t scans = std::max<size_t>(keys.size() / 100, 1);
+    measure("scan_100", scans, [&] {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < scans; ++i) {
+            size_t seen = 0;
+            list.scan(keys[i], [&](const uint64_t&, const uint64_t& value) {
+                sum += value;
+                return ++seen < 100;
+            });
+        }
+        sink = sum;
+    });
+    measure("remove", keys.size(), [&] {
+        uint64_t removed = 0;
+        for (uint64_t key : keys) removed += list.remove(key);
+        sink = removed;
+    });
+
+    std::printf("SkipList<uint64_t, uint64_t>, %zu entries, per operation\n", entries);
+    report.print(stdout);
+}
+
+// Each row is the best of kRadixTrials passes, so that scheduler noise
+// does not trip the comparison, and a pass makes at least kRadixLookups
+// lookups.
+constexpr size_t kRadixLookups = 1 << 16;
+constexpr int kRadixTrials = 5;
+constexpr double kRadixSlack = 1.5;
+
+// Times contains on probes, half of them present, with the radix head off
+// and at several widths; returns false if a width is slower than off.
+bool bench_radix_keys(const char* name, const std::vector<uint64_t>& keys,
+                      const std::vector<uint64_t>& probes) {
+    SkipList<uint64_t, uint64_t> list(kMaxLevel, 1);
+    for (uint64_t key : keys) list.put(key, key);
+    size_t rounds = std::max<size_t>(kRadixLookups / std::max<size_t>(probes.size(), 1), 1);
+
+    auto time_contains = [&] {
+        double best = 0;
+        for (int trial = 0; trial < kRadixTrials; ++trial) {
+            uint64_t found = 0;
+            auto start = Clock::now();
+            for (size_t r = 0; r < rounds; ++r) {
+                for (uint64_t key : probes) found += list.contains(key);
+            }
+            std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+            sink = found;
+            double ns = elapsed.count() / static_cast<double>(rounds * probes.size());
+            if (trial == 0 || ns < best) best = ns;
+        }
+        return best;
+    };
+
+    double plain = time_contains();
+    std::printf("%-8s %-6s %10.1f %8.2f\n", name, "off", plain, 1.0);
+    bool ok = true;
+    for (uint8_t bits : {2, 8, 12, 16, 20}) {
+        list.enable_radix_head(bits);
+        double ns = time_contains();
+        list.disable_radix_head();
+        bool slower = ns > plain * kRadixSlack;
+        std::printf("%-8s %-6u %10.1f %8.2f%s\n", name, static_cast<unsigned>(bits), ns,
+                    ns / plain, slower ? "  slower than off" : "");
+        ok = ok && !slower;
+    }
+    return ok;
+}
+
+bool bench_radix(size_t entries) {
+    std::printf("SkipList<uint64_t, uint64_t>, %zu entries, contains, half misses, "
+                "best of %d\n", entries, kRadixTrials);
+    std::printf("%-8s %-6s %10s %8s\n", "keys", "bits", "ns/op", "vs off");
+    // Dense keys all share the top bits, so the radix head cannot help and
+    // must not hurt; random ones spread over the buckets.
+    auto dense = shuffled_keys(entries, 1);
+    auto dense_probes = shuffled_keys(entries, 2);
+    for (size_t i = 0; i < dense_probes.size(); i += 2) dense_probes[i] += 1;
+
+    std::mt19937_64 gen(3);
+    std::vector<uint64_t> random(entries), random_probes(entries);
+    for (auto& key : random) key = gen();
+    for (size_t i = 0; i < random_probes.size(); ++i)
+        random_probes[i] = i % 2 ? random[gen() % entries] : gen();
+
+    bool ok = bench_radix_keys("dense", dense, dense_probes);
+    return bench_radix_keys("random", random, random_probes) && ok;
+}
+
+constexpr size_t kLatencyEntries = 1 << 20;
+
+void bench_latency(size_t threads, double ops_per_second, double seconds) {
+    SkipList<uint64_t, uint64_t> list(kMaxLevel, 1);
+    for (uint64_t key : shuffled_keys(kLatencyEntries, 1)) list.put(key, key);
+    std::printf("SkipList<uint64_t, uint64_t>, %zu entries, %.0f ops/s for %.0f s, "
+                "80%% get / 10%% put / 10%% remove, latency from the scheduled start\n",
+                kLatencyEntries, ops_per_second, seconds);
+
+    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::duration<double>(seconds));
+    for (size_t n : {size_t{1}, threads}) {
+        // One generator per thread, each only touched by its own thread.
+        std::vector<std::mt19937_64> gens;
+        for (size_t t = 0; t < n; ++t) gens.emplace_back(t + 1);
+        LatencyHistogram histogram =
+            momu::skip_list::run_open_loop(n, ops_per_second, duration, [&](size_t t, uint64_t) {
+                auto& gen = gens[t];
+                uint64_t key = gen() % (2 * kLatencyEntries);
+                uint64_t dice = gen() % 10;
+                if (dice == 0)
+                    list.put(key, key);
+                else if (dice == 1)
+                    list.remove(key);
+                else
+                    sink = list.get(key).value_or(0);
+            });
+        std::printf("%2zu thread%s  ", n, n == 1 ? " " : "s");
+        histogram.print(stdout);
+        if (n == threads) break;
+    }
+}
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: skip_list_bench ops|memory|radix [entries]\n"
+                 "       skip_list_bench latency [threads] [ops_per_second] [seconds]\n");
+    std::exit(2);
+}
+
+size_t size_arg(int argc, char** argv, int index, size_t fallback) {
+    return argc > index ? static_cast<size_t>(std::strtoull(argv[index], nullptr, 10))
+                        : fallback;
+}
+
+// Heap accounting through the replaced operator new and delete below. Only
+// the memory mode turns it on, so the other modes pay a single branch.
+// Both counts use malloc_usable_size, which the unsized delete can also
+// ask, so they stay exact across frees.
+struct HeapStats {
+    bool tracking_{false};
+    std::atomic<int64_t> usable_{0};
+    // Usable bytes plus glibc's chunk header, i.e. what malloc consumed.
+    std::atomic<int64_t> heap_{0};
+    std::atomic<int64_t> peak_heap_{0};
+};
+
+HeapStats heap_stats;
+
+constexpr int64_t kChunkHeader = sizeof(size_t);
+
+void track_allocation(void* p) {
+    if (!heap_stats.tracking_ || !p) return;
+    auto usable = static_cast<int64_t>(malloc_usable_size(p));
+    heap_stats.usable_.fetch_add(usable, std::memory_order_relaxed);
+    int64_t heap = heap_stats.heap_.fetch_add(usable + kChunkHeader, std::memory_order_relaxed) +
+                   usable + kChunkHeader;
+    int64_t peak = heap_stats.peak_heap_.load(std::memory_order_relaxed);
+    while (heap > peak && !heap_stats.peak_heap_.compare_exchange_weak(peak, heap)) {
+    }
+}
+
+void track_free(void* p) {
+    if (!heap_stats.tracking_ || !p) return;
+    auto usable = static_cast<int64_t>(malloc_usable_size(p));
+    heap_stats.usable_.fetch_sub(usable, std::memory_order_relaxed);
+    heap_stats.heap_.fetch_sub(usable + kChunkHeader, std::memory_order_relaxed);
+}
+
+int64_t resident_bytes() {
+    long pages = 0, resident = 0;
+    if (std::FILE* statm = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        std::fclose(statm);
+    }
+    return static_cast<int64_t>(resident) * ::sysconf(_SC_PAGESIZE);
+}
+
+struct Footprint {
+    double usable_;
+    double heap_;
+    double peak_heap_;
+    double resident_;
+    double own_;  // SkipList::memory_usage, negative for other containers
+};
+
+// Bulk-loads a container with load(), which returns it owned by a
+// unique_ptr, and reports per-entry deltas while it is still alive.
+template <typename Load, typename Own>
+Footprint measure_load(size_t entries, Load&& load, Own&& own) {
+    ::malloc_trim(0);
+    int64_t usable = heap_stats.usable_.load();
+    int64_t heap = heap_stats.heap_.load();
+    int64_t resident = resident_bytes();
+    heap_stats.peak_heap_.store(heap);
+
+    auto container = load();
+    double n = static_cast<double>(entries);
+    Footprint footprint{(heap_stats.usable_.load() - usable) / n,
+                        (heap_stats.heap_.load() - heap) / n,
+                        (heap_stats.peak_heap_.load() - heap) / n,
+                        (resident_bytes() - resident) / n, own(*container) / n};
+    container.reset();
+    return footprint;
+}
+
+template <typename T>
+T make_field(uint64_t i, size_t string_size) {
+    if constexpr (std::is_same_v<T, std::string>) {
+        std::string s = std::to_string(i * 2654435761u);
+        s.resize(string_size, '.');
+        return s;
+    } else {
+        return static_cast<T>(i * 2654435761u);
+    }
+}
+
+template <typename K, typename V>
+void bench_memory_for(const char* type, size_t entries, size_t key_string, size_t value_string) {
+    std::vector<std::pair<K, V>> input;
+    input.reserve(entries);
+    for (uint64_t i = 0; i < entries; ++i)
+        input.emplace_back(make_field<K>(i, key_string), make_field<V>(i, value_string));
+    std::shuffle(input.begin(), input.end(), std::mt19937_64(1));
+
+    auto none = [](const auto&) { return -1.0; };
+    auto report = [&](const char* container, const Footprint& f) {
+        std::printf("%-22s %-14s %9.1f %9.1f %9.1f %9.1f", type, container, f.usable_,
+                    f.heap_, f.peak_heap_, f.resident_);
+        if (f.own_ < 0)
+            std::printf(" %9s\n", "-");
+        else
+            std::printf(" %9.1f\n", f.own_);
+    };
+
+    report("SkipList", measure_load(
+                           entries,
+                           [&] {
+                               auto list = std::make_unique<SkipList<K, V>>(kMaxLevel, 1);
+                               for (const auto& [key, value] : input) list->put(key, value);
+                               return list;
+                           },
+                           [](const SkipList<K, V>& list) {
+                               return static_cast<double>(list.memory_usage());
+                           }));
+    report("std::map", measure_load(
+                           entries,
+                           [&] {
+                               auto map = std::make_unique<std::map<K, V>>();
+                               for (const auto& [key, value] : input) map->emplace(key, value);
+                               return map;
+                           },
+                           none));
+    report("unordered_map", measure_load(
+                                entries,
+                                [&] {
+                                    auto map = std::make_unique<std::unordered_map<K, V>>();
+                                    for (const auto& [key, value] : input)
+                                        map->emplace(key, value);
+                                    return map;
+                                },
+                                none));
+    report("sorted vector", measure_load(
+                                entries,
+                                [&] {
+                                    auto vec = std::make_unique<std::vector<std::pair<K, V>>>();
+                                    for (const auto& entry : input) vec->push_back(entry);
+                                    std::sort(vec->begin(), vec->end());
+                                    vec->shrink_to_fit();
+                                    return vec;
+                                },
+                                none));
+}
+
+void bench_memory(size_t entries) {
+    heap_stats.tracking_ = true;
+    std::printf("%zu entries, bytes per entry; own = SkipList::memory_usage, which leaves\n"
+                "out malloc overhead and what keys and values allocate\n", entries);
+    std::printf("%-22s %-14s %9s %9s %9s %9s %9s\n", "key -> value", "container", "usable",
+                "heap", "peak", "rss", "own");
+    bench_memory_for<uint32_t, uint32_t>("uint32 -> uint32", entries, 0, 0);
+    bench_memory_for<uint64_t, uint64_t>("uint64 -> uint64", entries, 0, 0);
+    bench_memory_for<std::string, uint64_t>("string(24) -> uint64", entries, 24, 0);
+    bench_memory_for<uint64_t, std::string>("uint64 -> string(100)", entries, 0, 100);
+    heap_stats.tracking_ = false;
+}
+
+// The replacements below take memory from malloc and give it back with
+// free. This stays out of line: inlined into a delete expression, the free
+// would sit next to the new that produced the pointer, and GCC reports the
+// pair as mismatched.
+[[gnu::noinline]] void release(void* p) {
+    track_free(p);
+    std::free(p);
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    track_allocation(p);
+    return p;
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    auto alignment = static_cast<size_t>(align);
+    void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (!p) throw std::bad_alloc();
+    track_allocation(p);
+    return p;
+}
+
+void operator delete(void* p) noexcept { release(p); }
+
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+
+void operator delete(void* p, std::align_val_t) noexcept { operator delete(p); }
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept { operator delete(p); }
+
+int main(int argc, char** argv) {
+    if (argc < 2) usage();
+    if (std::strcmp(argv[1], "ops") == 0)
+        bench_ops(size_arg(argc, argv, 2, 1 << 20));
+    else if (std::strcmp(argv[1], "memory") == 0)
+        bench_memory(size_arg(argc, argv, 2, 1 << 20));
+    else if (std::strcmp(argv[1], "radix") == 0)
+        return bench_radix(size_arg(argc, argv, 2, 1 << 20)) ? 0 : 1;
+    else if (std::strcmp(argv[1], "latency") == 0)
+        bench_latency(std::max<size_t>(size_arg(argc, argv, 2, 4), 1),
+                      argc > 3 ? std::atof(argv[3]) : 50000,
+                      argc > 4 ? std::atof(argv[4]) : 5);
+    else
+        usage();
+    return 0;
+}
@@ -0,0 +1,172 @@
+#ifndef MOMU_CHANGE_LOG_H
+#define MOMU_CHANGE_LOG_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "skip_list.h"
+
+namespace momu {
+namespace skip_list {
+
+template <typename K, typename V>
+struct ChangeRecord {
+    uint64_t sequence_;
+    Mutation op_;
+    K key_;
+    // Empty for removals.
+    std::optional<V> value_;
+};
+
+// Records every mutation of a SkipList into a fixed-size ring, numbered
+// from 1. Keys and values must be trivially copyable: each slot holds its
+// record as atomic words guarded by a per-slot sequence (a seqlock), so
+// the writer, the list's own listener, only does plain stores into
+// preallocated memory and no reader can hold it up. A consumer that falls
+// more than capacity records behind skips ahead and counts the records it
+// lost.
+template <typename K, typename V>
+class ChangeLog {
+   public:
+    using Record = ChangeRecord<K, V>;
+
+    static_assert(std::is_trivially_copyable_v<Record>,
+                  "ChangeLog needs trivially copyable keys and values");
+
+    class Cursor {
+       public:
+        // Appends up to max records to out and returns how many were added.
+        size_t poll(std::vector<Record>& out, size_t max) {
+            size_t added = 0;
+            uint64_t head = log_->published_.load(std::memory_order_acquire);
+            while (next_ <= head && added < max) {
+                Record record;
+                if (!log_->slot(next_).read(next_, record)) {
+                    head = skip_overwritten();
+                    continue;
+                }
+                out.push_back(record);
+                ++next_;
+                ++added;
+            }
+            return added;
+        }
+
+        uint64_t next_sequence() const { return next_; }
+        uint64_t lost() const { return lost_; }
+
+       private:
+        friend class ChangeLog;
+
+        Cursor(const ChangeLog& log, uint64_t next) : log_(&log), next_(next) {}
+
+        // The head poll started from may be older than the record that
+        // overwrote next_, so it is reloaded; returns it.
+        uint64_t skip_overwritten() {
+            uint64_t head = log_->published_.load(std::memory_order_acquire);
+            uint64_t oldest = log_->oldest_sequence(head);
+            if (oldest <= next_) oldest = next_ + 1;
+            lost_ += oldest - next_;
+            next_ = oldest;
+            return head;
+        }
+
+        const ChangeLog* log_;
+        uint64_t next_;
+        uint64_t lost_{0};
+    };
+
+    // capacity is rounded up to a power of two.
+    ChangeLog(SkipList<K, V>& list, size_t capacity)
+        : list_(list), slots_(round_up_to_power_of_two(capacity)) {
+        listener_id_ = list_.add_listener(
+            [this](Mutation op, const K& key, const V* value) {
+                append(op, key, value);
+            });
+    }
+
+    ChangeLog(const ChangeLog&) = delete;
+    ChangeLog& operator=(const ChangeLog&) = delete;
+
+    ~ChangeLog() { list_.remove_listener(listener_id_); }
+
+    uint64_t last_sequence() const {
+        return published_.load(std::memory_order_acquire);
+    }
+
+    // A cursor positioned after the newest record.
+    Cursor tail() const { return Cursor(*this, last_sequence() + 1); }
+
+    // A cursor positioned at the oldest record still in the ring.
+    Cursor oldest() const { return Cursor(*this, oldest_sequence(last_sequence())); }
+
+   private:
+    // The slot's sequence is 2s while it holds record s and 2s - 1 while
+    // record s is being written into it. Sequences only grow, so a reader
+    // looking for record s that sees anything but 2s, before or after
+    // copying, knows the record was overwritten.
+    struct Slot {
+        static constexpr size_t kWords = (sizeof(Record) + 7) / 8;
+
+        void write(const Record& record) {
+            std::array<uint64_t, kWords> buf{};
+            std::memcpy(buf.data(), &record, sizeof(Record));
+            // A reader that acquires any new word also sees the odd sequence.
+            sequence_.store(2 * record.sequence_ - 1, std::memory_order_relaxed);
+            for (size_t i = 0; i < kWords; ++i)
+                words_[i].store(buf[i], std::memory_order_release);
+            sequence_.store(2 * record.sequence_, std::memory_order_release);
+        }
+
+        bool read(uint64_t sequence, Record& record) const {
+            if (sequence_.load(std::memory_order_acquire) != 2 * sequence) return false;
+            std::array<uint64_t, kWords> buf;
+            for (size_t i = 0; i < kWords; ++i)
+                buf[i] = words_[i].load(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) != 2 * sequence) return false;
+            std::memcpy(static_cast<void*>(&record), buf.data(), sizeof(Record));
+            return true;
+        }
+
+        std::atomic<uint64_t> sequence_{0};
+        std::array<std::atomic<uint64_t>, kWords> words_{};
+    };
+
+    uint64_t oldest_sequence(uint64_t head) const {
+        return head >= slots_.size() ? head - slots_.size() + 1 : 1;
+    }
+
+    static size_t round_up_to_power_of_two(size_t n) {
+        size_t size = 1;
+        while (size < n) size <<= 1;
+        return size;
+    }
+
+    Slot& slot(uint64_t sequence) const {
+        return slots_[sequence & (slots_.size() - 1)];
+    }
+
+    // Runs under the list's lock, so there is exactly one writer.
+    void append(Mutation op, const K& key, const V* value) {
+        uint64_t sequence = published_.load(std::memory_order_relaxed) + 1;
+        std::optional<V> copy;
+        if (value) copy = *value;
+        slot(sequence).write(Record{sequence, op, key, copy});
+        published_.store(sequence, std::memory_order_release);
+    }
+
+    SkipList<K, V>& list_;
+    size_t listener_id_{0};
+    mutable std::vector<Slot> slots_;
+    std::atomic<uint64_t> published_{0};
+};
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_CHANGE_LOG_H
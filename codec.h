@@ -0,0 +1,102 @@
+#ifndef MOMU_CODEC_H
+#define MOMU_CODEC_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace momu {
+namespace skip_list {
+
+// Codec<T>::encode appends the bytes of a value to out; decode rebuilds it
+// from exactly size bytes and reports whether they were well formed.
+template <typename T, typename Enable = void>
+struct Codec;
+
+template <typename T>
+struct Codec<T, std::enable_if_t<std::is_trivially_copyable_v<T>>> {
+    static void encode(const T& value, std::string& out) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static bool decode(const char* data, size_t size, T& value) {
+        if (size != sizeof(T)) return false;
+        std::memcpy(&value, data, sizeof(T));
+        return true;
+    }
+};
+
+template <>
+struct Codec<std::string> {
+    static void encode(const std::string& value, std::string& out) { out += value; }
+
+    static bool decode(const char* data, size_t size, std::string& value) {
+        value.assign(data, size);
+        return true;
+    }
+};
+
+inline void put_fixed32(std::string& out, uint32_t v) {
+    char buf[4] = {static_cast<char>(v), static_cast<char>(v >> 8),
+                   static_cast<char>(v >> 16), static_cast<char>(v >> 24)};
+    out.append(buf, 4);
+}
+
+inline uint32_t get_fixed32(const char* p) {
+    auto* u = reinterpret_cast<const unsigned char*>(p);
+    return uint32_t{u[0]} | uint32_t{u[1]} << 8 | uint32_t{u[2]} << 16 |
+           uint32_t{u[3]} << 24;
+}
+
+inline void put_varint32(std::string& out, uint32_t v) {
+    while (v >= 0x80) {
+        out += static_cast<char>(v | 0x80);
+        v >>= 7;
+    }
+    out += static_cast<char>(v);
+}
+
+// Advances p past the varint; false if it is truncated or too long.
+inline bool get_varint32(const char*& p, const char* limit, uint32_t& v) {
+    v = 0;
+    for (int shift = 0; shift <= 28 && p < limit; shift += 7) {
+        auto byte = static_cast<unsigned char>(*p++);
+        v |= uint32_t{byte & 0x7fu} << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// CRC-32C (Castagnoli), continuing from crc so data can be fed in pieces.
+inline uint32_t crc32c(const char* data, size_t size, uint32_t crc = 0) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c >> 1) ^ (c & 1 ? 0x82f63b78u : 0);
+            t[i] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+// Appends a fixed32 length followed by the encoded value.
+template <typename Codec, typename T>
+void put_length_prefixed(std::string& out, const T& value) {
+    size_t at = out.size();
+    out.append(4, '\0');
+    Codec::encode(value, out);
+    auto len = static_cast<uint32_t>(out.size() - at - 4);
+    for (size_t i = 0; i < 4; ++i) out[at + i] = static_cast<char>(len >> (8 * i));
+}
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_CODEC_H
@@ -0,0 +1,224 @@
+#ifndef MOMU_INTERVAL_SKIP_LIST_H
+#define MOMU_INTERVAL_SKIP_LIST_H
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace momu {
+namespace skip_list {
+
+template <typename K, typename V>
+struct Interval {
+    K start_;
+    K end_;
+    V value_;
+};
+
+// max_end_[i] is the largest end among the nodes in (this, forward_[i]], so
+// a query can skip a whole link whose span ends before the query starts.
+template <typename K, typename V>
+struct IntervalNode {
+    IntervalNode() = default;
+    IntervalNode(const K& start, const K& end, const V& value, uint8_t level)
+        : key_(start), end_(end), value_(value), forward_(level + 1),
+          max_end_(level + 1) {}
+
+    IntervalNode(const IntervalNode&) = delete;
+    IntervalNode& operator=(const IntervalNode&) = delete;
+
+    K key_;
+    K end_;
+    V value_;
+    std::vector<std::shared_ptr<IntervalNode<K, V>>> forward_;
+    std::vector<K> max_end_;
+};
+
+// Closed intervals [start, end] keyed by start; putting an existing start
+// replaces its interval.
+template <typename K, typename V>
+class IntervalSkipList {
+   public:
+    explicit IntervalSkipList(uint8_t max_level,
+                              unsigned int seed = std::random_device{}())
+        : max_level_(max_level),
+          header_(std::make_unique<IntervalNode<K, V>>(K{}, K{}, V{}, max_level_)),
+          gen_(seed),
+          distribution_(0.5) {}
+
+    IntervalSkipList(const IntervalSkipList&) = delete;
+    IntervalSkipList& operator=(const IntervalSkipList&) = delete;
+
+    void put(const K& start, const K& end, const V& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto preds = find_predecessors(start);
+        auto* node = get_node_at_level_zero(preds[0], start);
+        if (node) {
+            node->end_ = end;
+            node->value_ = value;
+        } else {
+            node = insert_new_node(start, end, value, preds);
+        }
+        refresh_spans(preds, node);
+    }
+
+    std::optional<Interval<K, V>> get(const K& start) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto preds = find_predecessors(start);
+        if (auto* node = get_node_at_level_zero(preds[0], start))
+            return Interval<K, V>{node->key_, node->end_, node->value_};
+        return std::nullopt;
+    }
+
+    bool remove(const K& start) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto preds = find_predecessors(start);
+        auto* victim = get_node_at_level_zero(preds[0], start);
+        if (!victim) return false;
+
+        delete_node(victim, preds);
+        adjust_max_level();
+        refresh_spans(preds, nullptr);
+        return true;
+    }
+
+    // All intervals containing point.
+    std::vector<Interval<K, V>> stab(const K& point) {
+        return overlapping(point, point);
+    }
+
+    // All intervals intersecting [lo, hi], in order of start.
+    std::vector<Interval<K, V>> overlapping(const K& lo, const K& hi) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<Interval<K, V>> out;
+        collect_overlapping(header_.get(), current_max_level_, nullptr, lo, hi, out);
+        return out;
+    }
+
+    size_t size() const { return element_count_; }
+    bool empty() const { return element_count_ == 0; }
+
+   private:
+    using NodeT = IntervalNode<K, V>;
+    using PredVec = std::vector<NodeT*>;
+
+    PredVec find_predecessors(const K& key) {
+        PredVec preds(max_level_ + 1, nullptr);
+        NodeT* cur = header_.get();
+        for (int i = current_max_level_; i >= 0; --i) {
+            while (cur->forward_[i] && cur->forward_[i]->key_ < key)
+                cur = cur->forward_[i].get();
+            preds[i] = cur;
+        }
+        return preds;
+    }
+
+    NodeT* get_node_at_level_zero(NodeT* pred, const K& key) {
+        auto* nxt = pred->forward_[0].get();
+        return (nxt && nxt->key_ == key) ? nxt : nullptr;
+    }
+
+    // Walks the links of level lvl starting at x up to and including the
+    // link that ends at last, descending only into links whose span can
+    // hold an interval reaching lo. A link ending past hi may still cover
+    // smaller starts, so it is descended into before stopping. A null last
+    // means the end of the list, which no link at this level covers.
+    void collect_overlapping(NodeT* x, int lvl, const NodeT* last, const K& lo,
+                             const K& hi, std::vector<Interval<K, V>>& out) {
+        while (true) {
+            auto* y = x->forward_[lvl].get();
+            if (!y) {
+                if (lvl > 0) collect_overlapping(x, lvl - 1, nullptr, lo, hi, out);
+                break;
+            }
+            bool past_hi = hi < y->key_;
+            if (lvl == 0 && past_hi) break;
+            if (!(x->max_end_[lvl] < lo)) {
+                if (lvl == 0)
+                    out.push_back({y->key_, y->end_, y->value_});
+                else
+                    collect_overlapping(x, lvl - 1, y, lo, hi, out);
+            }
+            if (past_hi || y == last) break;
+            x = y;
+        }
+    }
+
+    NodeT* insert_new_node(const K& start, const K& end, const V& value,
+                           PredVec& preds) {
+        uint8_t lvl = generate_random_level();
+        if (lvl > current_max_level_) {
+            for (uint8_t i = current_max_level_ + 1; i <= lvl; ++i)
+                preds[i] = header_.get();
+            current_max_level_ = lvl;
+        }
+
+        auto node = std::make_shared<NodeT>(start, end, value, lvl);
+        for (uint8_t i = 0; i <= lvl; ++i) {
+            node->forward_[i] = preds[i]->forward_[i];
+            preds[i]->forward_[i] = node;
+        }
+        ++element_count_;
+        return node.get();
+    }
+
+    void delete_node(NodeT* node, const PredVec& preds) {
+        for (uint8_t i = 0; i <= current_max_level_; ++i) {
+            if (preds[i]->forward_[i].get() == node)
+                preds[i]->forward_[i] = node->forward_[i];
+        }
+        --element_count_;
+    }
+
+    // Recomputes bottom-up every span that covers the changed position: the
+    // node's own links and the predecessor link at each level.
+    void refresh_spans(const PredVec& preds, NodeT* node) {
+        for (int i = 0; i <= current_max_level_; ++i) {
+            if (node && i < static_cast<int>(node->forward_.size()))
+                recompute_span(node, i);
+            recompute_span(preds[i], i);
+        }
+    }
+
+    void recompute_span(NodeT* x, int lvl) {
+        auto* y = x->forward_[lvl].get();
+        if (!y) return;
+        if (lvl == 0) {
+            x->max_end_[0] = y->end_;
+            return;
+        }
+        K best = x->max_end_[lvl - 1];
+        for (auto* z = x->forward_[lvl - 1].get(); z != y;
+             z = z->forward_[lvl - 1].get()) {
+            if (best < z->max_end_[lvl - 1]) best = z->max_end_[lvl - 1];
+        }
+        x->max_end_[lvl] = best;
+    }
+
+    void adjust_max_level() {
+        while (current_max_level_ > 0 && !header_->forward_[current_max_level_])
+            --current_max_level_;
+    }
+
+    uint8_t generate_random_level() {
+        uint8_t lvl = 0;
+        while (distribution_(gen_) && lvl < max_level_) ++lvl;
+        return lvl;
+    }
+
+    uint8_t max_level_;
+    uint8_t current_max_level_{0};
+    std::unique_ptr<NodeT> header_;
+    size_t element_count_{0};
+
+    mutable std::mutex mutex_;
+    std::mt19937 gen_;
+    std::bernoulli_distribution distribution_;
+};
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_INTERVAL_SKIP_LIST_H
@@ -0,0 +1,42 @@
+#ifndef MOMU_KEY_PREFIX_H
+#define MOMU_KEY_PREFIX_H
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace momu {
+namespace skip_list {
+
+// Maps a key to a uint64_t that never decreases as keys increase. Integral
+// keys map one to one, signed ones with the sign bit flipped; strings map
+// to their first eight bytes, big endian, since they compare bytewise.
+template <typename K>
+std::enable_if_t<std::is_integral_v<K>, uint64_t> key_prefix(const K& key) {
+    if constexpr (std::is_signed_v<K>)
+        return static_cast<uint64_t>(static_cast<int64_t>(key)) ^ (uint64_t{1} << 63);
+    else
+        return static_cast<uint64_t>(key);
+}
+
+inline uint64_t key_prefix(const std::string& key) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        prefix <<= 8;
+        if (i < key.size()) prefix |= static_cast<unsigned char>(key[i]);
+    }
+    return prefix;
+}
+
+template <typename K, typename = void>
+struct HasKeyPrefix : std::false_type {};
+
+template <typename K>
+struct HasKeyPrefix<K, std::void_t<decltype(key_prefix(std::declval<const K&>()))>>
+    : std::true_type {};
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_KEY_PREFIX_H
@@ -0,0 +1,133 @@
+#ifndef MOMU_LATENCY_H
+#define MOMU_LATENCY_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace momu {
+namespace skip_list {
+
+// Log-linear histogram in the style of HdrHistogram: exact below 128, then
+// 64 sub-buckets per power of two, so every recorded value is reported
+// within 1.6% over the whole uint64_t range in a fixed 30 KiB.
+class LatencyHistogram {
+   public:
+    void record(uint64_t value, uint64_t count = 1) {
+        counts_[index_of(value)] += count;
+        total_ += count;
+        max_ = std::max(max_, value);
+    }
+
+    // For closed-loop measurements: a value longer than the interval at
+    // which requests were due means requests were not issued meanwhile, so
+    // the latencies they would have seen are added back as well.
+    void record_corrected(uint64_t value, uint64_t expected_interval) {
+        record(value);
+        if (expected_interval == 0) return;
+        for (uint64_t missed = value - std::min(value, expected_interval);
+             missed >= expected_interval; missed -= expected_interval)
+            record(missed);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < kBuckets; ++i) counts_[i] += other.counts_[i];
+        total_ += other.total_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    uint64_t count() const { return total_; }
+    uint64_t max() const { return max_; }
+
+    // The smallest recorded value v such that percent of values are <= v,
+    // reported as the top of its bucket.
+    uint64_t percentile(double percent) const {
+        if (total_ == 0) return 0;
+        auto rank = static_cast<uint64_t>(percent / 100.0 * total_ + 0.5);
+        rank = std::clamp<uint64_t>(rank, 1, total_);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) return std::min(highest_of(i), max_);
+        }
+        return max_;
+    }
+
+    void print(std::FILE* out, const char* unit = "ns") const {
+        static constexpr double kPercentiles[] = {50, 90, 99, 99.9, 99.99};
+        std::fprintf(out, "count %llu", static_cast<unsigned long long>(total_));
+        for (double p : kPercentiles)
+            std::fprintf(out, "  p%g %llu%s", p,
+                         static_cast<unsigned long long>(percentile(p)), unit);
+        std::fprintf(out, "  max %llu%s\n", static_cast<unsigned long long>(max_), unit);
+    }
+
+   private:
+    static constexpr int kSubBits = 7;
+    static constexpr uint64_t kSub = uint64_t{1} << kSubBits;
+    static constexpr uint64_t kHalf = kSub / 2;
+    static constexpr size_t kBuckets = kSub + (64 - kSubBits) * kHalf;
+
+    static size_t index_of(uint64_t value) {
+        if (value < kSub) return value;
+        int shift = 63 - __builtin_clzll(value) - (kSubBits - 1);
+        return kSub + (shift - 1) * kHalf + ((value >> shift) - kHalf);
+    }
+
+    static uint64_t highest_of(size_t index) {
+        if (index < kSub) return index;
+        int shift = static_cast<int>((index - kSub) / kHalf) + 1;
+        uint64_t sub = (index - kSub) % kHalf + kHalf;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::array<uint64_t, kBuckets> counts_{};
+    uint64_t total_{0};
+    uint64_t max_{0};
+};
+
+// Open-loop load: each of threads issues op(thread, i) on a fixed schedule
+// adding up to ops_per_second, whether or not earlier calls finished in
+// time. Latency is measured from when a call was due rather than when it
+// started, so stalls (lock convoys on a list's mutex, say) show up in every
+// call queued behind them instead of being omitted. Returns the merged
+// histogram in nanoseconds.
+template <typename Fn>
+LatencyHistogram run_open_loop(size_t threads, double ops_per_second,
+                               std::chrono::nanoseconds duration, Fn&& op) {
+    using Clock = std::chrono::steady_clock;
+    auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(threads / ops_per_second));
+    auto start = Clock::now() + std::chrono::milliseconds(1);
+    auto end = start + duration;
+
+    std::vector<LatencyHistogram> histograms(threads);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            // Threads are staggered so their calls interleave evenly.
+            auto due = start + interval * t / threads;
+            for (uint64_t i = 0; due < end; ++i, due += interval) {
+                std::this_thread::sleep_until(due);
+                op(t, i);
+                auto latency = Clock::now() - due;
+                histograms[t].record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count()));
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    LatencyHistogram merged;
+    for (const auto& histogram : histograms) merged.merge(histogram);
+    return merged;
+}
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_LATENCY_H
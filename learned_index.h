@@ -0,0 +1,107 @@
+#ifndef MOMU_LEARNED_INDEX_H
+#define MOMU_LEARNED_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "key_prefix.h"
+
+namespace momu {
+namespace skip_list {
+
+// A piecewise-linear model from integral keys to positions in a sorted array
+// of nodes, fitted greedily with a shrinking slope cone so that every node
+// is predicted within max_error positions (in the spirit of PGM and
+// RadixSpline). Nodes only need a key_ member.
+template <typename NodeT>
+class LearnedIndex {
+   public:
+    LearnedIndex(std::vector<NodeT*> nodes, size_t max_error)
+        : nodes_(std::move(nodes)), max_error_(max_error) {
+        fit();
+    }
+
+    size_t node_count() const { return nodes_.size(); }
+    size_t segment_count() const { return segments_.size(); }
+
+    // Heap bytes of the node array and the segments, not counting *this.
+    size_t memory_usage() const {
+        return nodes_.capacity() * sizeof(NodeT*) + segments_.capacity() * sizeof(Segment);
+    }
+
+    // The last node whose key is less than key, or null if there is none.
+    template <typename K>
+    NodeT* predecessor(const K& key) const {
+        if (nodes_.empty() || !(nodes_.front()->key_ < key)) return nullptr;
+        size_t pos = predict(key);
+        size_t lo = pos > max_error_ + 1 ? pos - max_error_ - 1 : 0;
+        size_t hi = std::min(pos + max_error_ + 1, nodes_.size());
+        // Keys between segments can be predicted outside the bound; fall
+        // back to the whole array then.
+        if (!(nodes_[lo]->key_ < key) || (hi < nodes_.size() && nodes_[hi]->key_ < key)) {
+            lo = 0;
+            hi = nodes_.size();
+        }
+        auto it = std::lower_bound(nodes_.begin() + lo, nodes_.begin() + hi, key,
+                                   [](const NodeT* node, const K& k) { return node->key_ < k; });
+        return *(it - 1);
+    }
+
+   private:
+    struct Segment {
+        uint64_t first_key_;
+        size_t first_index_;
+        double slope_;
+    };
+
+    void fit() {
+        size_t start = 0;
+        double lo = 0, hi = 0;
+        for (size_t i = 1; i <= nodes_.size(); ++i) {
+            if (i < nodes_.size()) {
+                uint64_t run = key_prefix(nodes_[i]->key_) - key_prefix(nodes_[start]->key_);
+                double dx = static_cast<double>(run);
+                double dy = static_cast<double>(i - start);
+                double new_lo = (dy - max_error_) / dx;
+                double new_hi = (dy + max_error_) / dx;
+                if (i == start + 1) {
+                    lo = new_lo;
+                    hi = new_hi;
+                    continue;
+                }
+                if (std::max(lo, new_lo) <= std::min(hi, new_hi)) {
+                    lo = std::max(lo, new_lo);
+                    hi = std::min(hi, new_hi);
+                    continue;
+                }
+            }
+            double slope = i == start + 1 ? 0 : (lo + hi) / 2;
+            segments_.push_back({key_prefix(nodes_[start]->key_), start, slope});
+            start = i;
+        }
+    }
+
+    template <typename K>
+    size_t predict(const K& key) const {
+        uint64_t x = key_prefix(key);
+        auto it = std::upper_bound(segments_.begin(), segments_.end(), x,
+                                   [](uint64_t k, const Segment& segment) {
+                                       return k < segment.first_key_;
+                                   });
+        const Segment& segment = *(it - 1);
+        double offset = segment.slope_ * static_cast<double>(x - segment.first_key_);
+        auto pos = segment.first_index_ + static_cast<size_t>(std::max(0.0, offset));
+        return std::min(pos, nodes_.size() - 1);
+    }
+
+    std::vector<NodeT*> nodes_;
+    size_t max_error_;
+    std::vector<Segment> segments_;
+};
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_LEARNED_INDEX_H
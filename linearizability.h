@@ -0,0 +1,207 @@
+#ifndef MOMU_LINEARIZABILITY_H
+#define MOMU_LINEARIZABILITY_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "skip_list.h"
+
+namespace momu {
+namespace skip_list {
+
+enum class HistoryOp { kPut, kGet, kRemove, kContains };
+
+// One completed operation. invoke_ and response_ come from a single counter
+// shared by all threads, so they order every call and return in the history.
+template <typename K, typename V>
+struct HistoryEvent {
+    HistoryOp op_;
+    K key_;
+    V value_;                     // argument of kPut
+    std::optional<V> found_;      // result of kGet
+    bool result_{false};          // result of kRemove and kContains
+    uint64_t invoke_;
+    uint64_t response_;
+};
+
+// Wraps a list so that operations issued through it from many threads are
+// recorded as a history for is_linearizable.
+template <typename K, typename V>
+class HistoryRecorder {
+   public:
+    using Event = HistoryEvent<K, V>;
+
+    explicit HistoryRecorder(SkipList<K, V>& list) : list_(list) {}
+
+    void put(const K& key, const V& value) {
+        uint64_t invoke = tick();
+        list_.put(key, value);
+        record(Event{HistoryOp::kPut, key, value, std::nullopt, false, invoke, tick()});
+    }
+
+    std::optional<V> get(const K& key) {
+        uint64_t invoke = tick();
+        auto found = list_.get(key);
+        record(Event{HistoryOp::kGet, key, V{}, found, false, invoke, tick()});
+        return found;
+    }
+
+    bool remove(const K& key) {
+        uint64_t invoke = tick();
+        bool removed = list_.remove(key);
+        record(Event{HistoryOp::kRemove, key, V{}, std::nullopt, removed, invoke, tick()});
+        return removed;
+    }
+
+    bool contains(const K& key) {
+        uint64_t invoke = tick();
+        bool found = list_.contains(key);
+        record(Event{HistoryOp::kContains, key, V{}, std::nullopt, found, invoke, tick()});
+        return found;
+    }
+
+    std::vector<Event> history() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return events_;
+    }
+
+   private:
+    uint64_t tick() { return clock_.fetch_add(1, std::memory_order_seq_cst); }
+
+    void record(Event event) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        events_.push_back(std::move(event));
+    }
+
+    SkipList<K, V>& list_;
+    std::atomic<uint64_t> clock_{0};
+    std::mutex mutex_;
+    std::vector<Event> events_;
+};
+
+// Checks one key's operations against a register that starts empty, by
+// Wing and Gong's search with Lowe's pruning: a (linearized set, state)
+// pair that was already explored is not explored again.
+template <typename K, typename V>
+bool is_linearizable_register(const std::vector<const HistoryEvent<K, V>*>& ops) {
+    // Calls and returns as a doubly linked list in time order. Index 0 is
+    // the list head; call i and its return are 2i + 1 and 2i + 2.
+    struct Entry {
+        uint64_t time_;
+        size_t op_;
+        bool call_;
+        size_t prev_;
+        size_t next_;
+    };
+    constexpr size_t kNone = static_cast<size_t>(-1);
+    std::vector<Entry> entries(1, Entry{0, 0, false, kNone, kNone});
+    for (size_t i = 0; i < ops.size(); ++i) {
+        entries.push_back(Entry{ops[i]->invoke_, i, true, kNone, kNone});
+        entries.push_back(Entry{ops[i]->response_, i, false, kNone, kNone});
+    }
+    std::vector<size_t> order;
+    for (size_t i = 1; i < entries.size(); ++i) order.push_back(i);
+    std::sort(order.begin(), order.end(), [&entries](size_t a, size_t b) {
+        return entries[a].time_ < entries[b].time_;
+    });
+    size_t last = 0;
+    for (size_t index : order) {
+        entries[last].next_ = index;
+        entries[index].prev_ = last;
+        last = index;
+    }
+
+    auto unlink = [&entries](size_t i) {
+        entries[entries[i].prev_].next_ = entries[i].next_;
+        if (entries[i].next_ != kNone) entries[entries[i].next_].prev_ = entries[i].prev_;
+    };
+    auto relink = [&entries](size_t i) {
+        entries[entries[i].prev_].next_ = i;
+        if (entries[i].next_ != kNone) entries[entries[i].next_].prev_ = i;
+    };
+
+    // Applies an operation to the register; false if its result contradicts
+    // the state.
+    auto apply = [](const HistoryEvent<K, V>& op, std::optional<V>& state) {
+        switch (op.op_) {
+            case HistoryOp::kPut:
+                state = op.value_;
+                return true;
+            case HistoryOp::kGet:
+                return op.found_ == state;
+            case HistoryOp::kRemove:
+                if (op.result_ != state.has_value()) return false;
+                state.reset();
+                return true;
+            case HistoryOp::kContains:
+                return op.result_ == state.has_value();
+        }
+        return false;
+    };
+
+    std::optional<V> state;
+    std::vector<bool> linearized(ops.size());
+    std::set<std::pair<std::vector<bool>, std::optional<V>>> seen;
+    std::vector<std::pair<size_t, std::optional<V>>> stack;
+
+    size_t cur = entries[0].next_;
+    while (entries[0].next_ != kNone) {
+        const Entry& entry = entries[cur];
+        if (entry.call_) {
+            auto next_state = state;
+            bool explore = apply(*ops[entry.op_], next_state);
+            if (explore) {
+                linearized[entry.op_] = true;
+                explore = seen.emplace(linearized, next_state).second;
+                if (!explore) linearized[entry.op_] = false;
+            }
+            if (explore) {
+                stack.emplace_back(cur, std::move(state));
+                state = std::move(next_state);
+                unlink(cur);
+                unlink(cur + 1);
+                cur = entries[0].next_;
+            } else {
+                cur = entry.next_;
+            }
+        } else {
+            // A return is reached before its call was linearized: undo the
+            // most recent choice and try the next call after it.
+            if (stack.empty()) return false;
+            auto [call, previous] = std::move(stack.back());
+            stack.pop_back();
+            state = std::move(previous);
+            linearized[entries[call].op_] = false;
+            relink(call + 1);
+            relink(call);
+            cur = entries[call].next_;
+        }
+    }
+    return true;
+}
+
+// Checks a history of a map that starts empty against the sequential map
+// model. Operations on different keys commute, so each key's subhistory is
+// checked on its own as a register, which keeps the search small. V must
+// be ordered.
+template <typename K, typename V>
+bool is_linearizable(const std::vector<HistoryEvent<K, V>>& history) {
+    std::map<K, std::vector<const HistoryEvent<K, V>*>> by_key;
+    for (const auto& event : history) by_key[event.key_].push_back(&event);
+    for (const auto& entry : by_key) {
+        if (!is_linearizable_register(entry.second)) return false;
+    }
+    return true;
+}
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_LINEARIZABILITY_H
@@ -0,0 +1,385 @@
+#ifndef MOMU_LOG_WRITER_H
+#define MOMU_LOG_WRITER_H
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define MOMU_SKIP_LIST_HAS_IO_URING 1
+#endif
+
+#include "codec.h"
+#include "replication.h"
+#include "skip_list.h"
+
+namespace momu {
+namespace skip_list {
+
+#ifdef MOMU_SKIP_LIST_HAS_IO_URING
+
+// Just enough of io_uring for the log writer: a fixed set of registered
+// buffers, WRITE_FIXED and FSYNC submissions, and a blocking reap. Used by a
+// single thread.
+class IoUring {
+   public:
+    static constexpr unsigned kBuffers = 4;
+
+    IoUring() = default;
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    ~IoUring() {
+        if (sqes_) ::munmap(sqes_, sqes_size_);
+        if (cq_ptr_ && cq_ptr_ != sq_ptr_) ::munmap(cq_ptr_, cq_size_);
+        if (sq_ptr_) ::munmap(sq_ptr_, sq_size_);
+        if (ring_fd_ >= 0) ::close(ring_fd_);
+        for (auto& buf : buffers_) std::free(buf.iov_base);
+    }
+
+    bool init(size_t buffer_size) {
+        io_uring_params params{};
+        ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, 2 * kBuffers, &params));
+        if (ring_fd_ < 0) return false;
+
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+
+        sq_ptr_ = map(sq_size_, IORING_OFF_SQ_RING);
+        cq_ptr_ = single_mmap ? sq_ptr_ : map(cq_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+        if (!sq_ptr_ || !cq_ptr_ || !sqes_) return false;
+
+        auto* sq = static_cast<char*>(sq_ptr_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        auto* cq = static_cast<char*>(cq_ptr_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        for (unsigned i = 0; i < kBuffers; ++i) {
+            void* mem = nullptr;
+            if (::posix_memalign(&mem, 4096, buffer_size) != 0) return false;
+            buffers_.push_back({mem, buffer_size});
+        }
+        return ::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS,
+                         buffers_.data(), kBuffers) == 0;
+    }
+
+    size_t buffer_size() const { return buffers_[0].iov_len; }
+    char* buffer(unsigned index) { return static_cast<char*>(buffers_[index].iov_base); }
+
+    // Writes len bytes of buffer index, starting skip bytes in, at offset.
+    // At most one write per buffer may be in flight.
+    void prepare_write(int fd, unsigned index, size_t skip, size_t len, uint64_t offset) {
+        auto* sqe = next_sqe();
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(buffer(index) + skip);
+        sqe->len = static_cast<uint32_t>(len);
+        sqe->off = offset;
+        sqe->buf_index = static_cast<uint16_t>(index);
+        sqe->user_data = index;
+        written_[index] = 0;
+    }
+
+    // Ordered after every write prepared before it.
+    void prepare_datasync(int fd) {
+        auto* sqe = next_sqe();
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fd = fd;
+        sqe->flags = IOSQE_IO_DRAIN;
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        sqe->user_data = kSyncTag;
+    }
+
+    // Bytes the last write from buffer index wrote, which can be short.
+    size_t written(unsigned index) const { return written_[index]; }
+
+    // Submits everything prepared and waits for all of it; false if any
+    // operation failed or a write made no progress.
+    bool submit_and_wait() {
+        __atomic_store_n(sq_tail_, local_tail_, __ATOMIC_RELEASE);
+        unsigned to_submit = prepared_;
+        unsigned to_reap = prepared_;
+        prepared_ = 0;
+
+        bool ok = true;
+        unsigned head = *cq_head_;
+        while (to_reap > 0) {
+            unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            if (head == tail) {
+                long n = ::syscall(__NR_io_uring_enter, ring_fd_, to_submit, 1,
+                                   IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (n < 0 && errno != EINTR) return false;
+                if (n > 0) to_submit -= static_cast<unsigned>(n);
+                continue;
+            }
+            const auto& cqe = cqes_[head & cq_mask_];
+            if (cqe.res < 0) {
+                ok = false;
+            } else if (cqe.user_data != kSyncTag) {
+                if (cqe.res == 0) ok = false;
+                written_[cqe.user_data] = static_cast<size_t>(cqe.res);
+            }
+            ++head;
+            --to_reap;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        return ok;
+    }
+
+   private:
+    static constexpr uint64_t kSyncTag = ~uint64_t{0};
+
+    void* map(size_t size, uint64_t offset) {
+        void* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    io_uring_sqe* next_sqe() {
+        unsigned index = local_tail_ & sq_mask_;
+        auto* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array_[index] = index;
+        ++local_tail_;
+        ++prepared_;
+        return sqe;
+    }
+
+    int ring_fd_{-1};
+    void* sq_ptr_{nullptr};
+    void* cq_ptr_{nullptr};
+    io_uring_sqe* sqes_{nullptr};
+    size_t sq_size_{0};
+    size_t cq_size_{0};
+    size_t sqes_size_{0};
+
+    unsigned* sq_tail_{nullptr};
+    unsigned sq_mask_{0};
+    unsigned* sq_array_{nullptr};
+    unsigned* cq_head_{nullptr};
+    unsigned* cq_tail_{nullptr};
+    unsigned cq_mask_{0};
+    io_uring_cqe* cqes_{nullptr};
+
+    unsigned local_tail_{0};
+    unsigned prepared_{0};
+    std::vector<iovec> buffers_;
+    std::array<size_t, kBuffers> written_{};
+};
+
+#endif  // MOMU_SKIP_LIST_HAS_IO_URING
+
+// Appends every mutation of a list to fd in the replication frame format, so
+// a log can be replayed with ReplicationFollower. Mutations are only copied
+// into a pending buffer under a short lock; a writer thread drains it in
+// batches, writing at increasing offsets from the current end of fd and then
+// syncing the data. With io_uring the batch is copied into registered
+// buffers and the writes plus the sync go out in one submission; otherwise,
+// or when io_uring is unavailable, it uses pwritev and fdatasync.
+template <typename K, typename V, typename KeyCodec = Codec<K>,
+          typename ValueCodec = Codec<V>>
+class LogWriter {
+   public:
+    enum class Backend { kIoUring, kSync };
+
+    LogWriter(SkipList<K, V>& list, int fd, Backend preferred = Backend::kIoUring,
+              size_t buffer_size = 1 << 20)
+        : list_(list), fd_(fd), offset_(::lseek(fd, 0, SEEK_END)) {
+        if (offset_ < 0) offset_ = 0;
+#ifdef MOMU_SKIP_LIST_HAS_IO_URING
+        if (preferred == Backend::kIoUring && ring_.init(buffer_size))
+            backend_ = Backend::kIoUring;
+#else
+        (void)preferred;
+        (void)buffer_size;
+#endif
+        writer_ = std::thread([this] { run(); });
+        listener_id_ = list_.add_listener(
+            [this](Mutation op, const K& key, const V* value) {
+                append(encode_mutation<KeyCodec, ValueCodec>(op, key, value));
+            });
+    }
+
+    LogWriter(const LogWriter&) = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+
+    // Writes and syncs whatever is still pending before returning.
+    ~LogWriter() {
+        list_.remove_listener(listener_id_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            pending_ready_.notify_one();
+        }
+        writer_.join();
+    }
+
+    Backend backend() const { return backend_; }
+
+    // Mutations are numbered from 1 in the order they were logged.
+    uint64_t appended_sequence() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return appended_;
+    }
+
+    uint64_t durable_sequence() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return durable_;
+    }
+
+    // Blocks until every mutation logged before the call is durable.
+    // Returns false once the writer has hit an I/O error.
+    bool flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        uint64_t target = appended_;
+        durable_ready_.wait(lock, [&] { return failed_ || durable_ >= target; });
+        return !failed_;
+    }
+
+   private:
+    // Nothing is buffered once the writer has failed, since nothing will
+    // ever drain it.
+    void append(std::string frame) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (failed_) return;
+        pending_ += frame;
+        ++appended_;
+        pending_ready_.notify_one();
+    }
+
+    void run() {
+        std::string batch;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            pending_ready_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+            if (pending_.empty() || failed_) return;
+            batch.swap(pending_);
+            uint64_t sequence = appended_;
+            lock.unlock();
+
+            bool ok = write_batch(batch);
+            batch.clear();
+
+            lock.lock();
+            if (ok) {
+                durable_ = sequence;
+            } else {
+                failed_ = true;
+                std::string().swap(pending_);
+            }
+            durable_ready_.notify_all();
+        }
+    }
+
+    bool write_batch(const std::string& batch) {
+#ifdef MOMU_SKIP_LIST_HAS_IO_URING
+        if (backend_ == Backend::kIoUring) return write_batch_io_uring(batch);
+#endif
+        return write_batch_sync(batch);
+    }
+
+#ifdef MOMU_SKIP_LIST_HAS_IO_URING
+    // Every round fills up to kBuffers registered buffers; the last round
+    // also carries the datasync, drained behind the writes. Short writes are
+    // resubmitted from where they stopped, with the datasync behind them
+    // again if the round carries it.
+    bool write_batch_io_uring(const std::string& batch) {
+        struct Chunk {
+            uint64_t offset_;
+            size_t len_;
+            size_t written_;
+        };
+        size_t done = 0;
+        while (done < batch.size()) {
+            std::array<Chunk, IoUring::kBuffers> chunks;
+            unsigned used = 0;
+            for (; used < IoUring::kBuffers && done < batch.size(); ++used) {
+                size_t len = std::min(ring_.buffer_size(), batch.size() - done);
+                std::memcpy(ring_.buffer(used), batch.data() + done, len);
+                chunks[used] = {static_cast<uint64_t>(offset_), len, 0};
+                offset_ += static_cast<off_t>(len);
+                done += len;
+            }
+            bool last = done == batch.size();
+            while (true) {
+                bool short_write = false;
+                for (unsigned i = 0; i < used; ++i) {
+                    auto& chunk = chunks[i];
+                    if (chunk.written_ == chunk.len_) continue;
+                    ring_.prepare_write(fd_, i, chunk.written_, chunk.len_ - chunk.written_,
+                                        chunk.offset_ + chunk.written_);
+                    short_write = true;
+                }
+                if (!short_write) break;
+                if (last) ring_.prepare_datasync(fd_);
+                if (!ring_.submit_and_wait()) return false;
+                for (unsigned i = 0; i < used; ++i) {
+                    auto& chunk = chunks[i];
+                    if (chunk.written_ < chunk.len_) chunk.written_ += ring_.written(i);
+                }
+            }
+        }
+        return true;
+    }
+#endif
+
+    bool write_batch_sync(const std::string& batch) {
+        size_t done = 0;
+        while (done < batch.size()) {
+            iovec iov{const_cast<char*>(batch.data() + done), batch.size() - done};
+            ssize_t n = ::pwritev(fd_, &iov, 1, offset_);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            offset_ += n;
+            done += static_cast<size_t>(n);
+        }
+        return ::fdatasync(fd_) == 0;
+    }
+
+    SkipList<K, V>& list_;
+    const int fd_;
+    off_t offset_;
+    Backend backend_{Backend::kSync};
+#ifdef MOMU_SKIP_LIST_HAS_IO_URING
+    IoUring ring_;
+#endif
+    size_t listener_id_{0};
+
+    std::mutex mutex_;
+    std::condition_variable pending_ready_;
+    std::condition_variable durable_ready_;
+    std::string pending_;
+    uint64_t appended_{0};
+    uint64_t durable_{0};
+    bool stopping_{false};
+    bool failed_{false};
+    std::thread writer_;
+};
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_LOG_WRITER_H
@@ -0,0 +1,186 @@
+#ifndef MOMU_PERF_COUNTERS_H
+#define MOMU_PERF_COUNTERS_H
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+
+namespace momu {
+namespace skip_list {
+
+enum class PerfEvent { kCycles, kInstructions, kLlcMisses, kDtlbMisses, kBranchMisses };
+
+constexpr size_t kPerfEventCount = 5;
+
+struct PerfSample {
+    std::array<uint64_t, kPerfEventCount> values_{};
+    std::array<bool, kPerfEventCount> valid_{};
+
+    uint64_t operator[](PerfEvent event) const { return values_[static_cast<size_t>(event)]; }
+};
+
+// Hardware counters for the calling thread, read as one perf_event group so
+// they cover the same interval. Only user-space events are counted, which
+// perf_event_paranoid up to 2 allows without privileges. Events the CPU or
+// kernel refuses (common in VMs) are left out and reported as invalid.
+class PerfCounters {
+   public:
+    PerfCounters() {
+        for (size_t i = 0; i < kPerfEventCount; ++i) {
+            fds_[i] = open_event(static_cast<PerfEvent>(i), leader_);
+            if (fds_[i] < 0) continue;
+            if (leader_ < 0) leader_ = fds_[i];
+            ::ioctl(fds_[i], PERF_EVENT_IOC_ID, &ids_[i]);
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+        for (int fd : fds_) {
+            if (fd >= 0) ::close(fd);
+        }
+    }
+
+    bool available(PerfEvent event) const { return fds_[static_cast<size_t>(event)] >= 0; }
+
+    void start() {
+        if (leader_ < 0) return;
+        ::ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    // Counts since start(), scaled up if the group was multiplexed.
+    PerfSample stop() {
+        PerfSample sample;
+        if (leader_ < 0) return sample;
+        ::ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // nr, time_enabled, time_running, then an (value, id) pair per event.
+        uint64_t buf[3 + 2 * kPerfEventCount];
+        if (::read(leader_, buf, sizeof(buf)) < static_cast<ssize_t>(3 * sizeof(uint64_t)))
+            return sample;
+        uint64_t enabled = buf[1];
+        uint64_t running = buf[2];
+        for (uint64_t j = 0; j < buf[0]; ++j) {
+            uint64_t value = buf[3 + 2 * j];
+            if (running > 0 && running < enabled)
+                value = static_cast<uint64_t>(static_cast<double>(value) * enabled / running);
+            for (size_t i = 0; i < kPerfEventCount; ++i) {
+                if (fds_[i] < 0 || ids_[i] != buf[4 + 2 * j]) continue;
+                sample.values_[i] = value;
+                sample.valid_[i] = running > 0;
+            }
+        }
+        return sample;
+    }
+
+    template <typename Fn>
+    PerfSample measure(Fn&& fn) {
+        start();
+        fn();
+        return stop();
+    }
+
+   private:
+    static int open_event(PerfEvent event, int group) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.disabled = group < 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                           PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        switch (event) {
+            case PerfEvent::kCycles:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case PerfEvent::kInstructions:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case PerfEvent::kLlcMisses:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                break;
+            case PerfEvent::kDtlbMisses:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                              PERF_COUNT_HW_CACHE_OP_READ << 8 |
+                              PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+                break;
+            case PerfEvent::kBranchMisses:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+        }
+        return static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, group, 0));
+    }
+
+    std::array<int, kPerfEventCount> fds_{};
+    std::array<uint64_t, kPerfEventCount> ids_{};
+    int leader_{-1};
+};
+
+// Accumulates samples per operation type and prints per-operation averages,
+// with wall time alongside the counters when it is given.
+class PerfReport {
+   public:
+    void add(const std::string& op, const PerfSample& sample, uint64_t ops,
+             std::chrono::nanoseconds elapsed = {}) {
+        auto& totals = totals_[op];
+        totals.ops_ += ops;
+        totals.nanoseconds_ += static_cast<uint64_t>(elapsed.count());
+        for (size_t i = 0; i < kPerfEventCount; ++i) {
+            totals.sample_.values_[i] += sample.values_[i];
+            totals.sample_.valid_[i] = totals.sample_.valid_[i] || sample.valid_[i];
+        }
+    }
+
+    void print(std::FILE* out) const {
+        std::fprintf(out, "%-12s %12s %10s %10s %10s %10s %10s %10s\n", "op", "ops", "ns",
+                     "cycles", "instr", "llc-miss", "dtlb-miss", "br-miss");
+        for (const auto& [op, totals] : totals_) {
+            std::fprintf(out, "%-12s %12llu", op.c_str(),
+                         static_cast<unsigned long long>(totals.ops_));
+            if (totals.nanoseconds_ == 0 || totals.ops_ == 0)
+                std::fprintf(out, " %10s", "-");
+            else
+                std::fprintf(out, " %10.1f",
+                             static_cast<double>(totals.nanoseconds_) / totals.ops_);
+            for (size_t i = 0; i < kPerfEventCount; ++i) {
+                if (!totals.sample_.valid_[i] || totals.ops_ == 0)
+                    std::fprintf(out, " %10s", "-");
+                else
+                    std::fprintf(out, " %10.2f",
+                                 static_cast<double>(totals.sample_.values_[i]) / totals.ops_);
+            }
+            std::fprintf(out, "\n");
+        }
+    }
+
+   private:
+    struct Totals {
+        uint64_t ops_{0};
+        uint64_t nanoseconds_{0};
+        PerfSample sample_;
+    };
+
+    std::map<std::string, Totals> totals_;
+};
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_PERF_COUNTERS_H
@@ -0,0 +1,304 @@
+#ifndef MOMU_POSTING_LIST_H
+#define MOMU_POSTING_LIST_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "skip_list.h"
+
+namespace momu {
+namespace skip_list {
+
+// A block of up to kBlockSize sorted ids. The first id is the node key; the
+// remaining ids are stored as (delta - 1) bit-packed at a fixed width, so a
+// run of consecutive ids costs no payload bits at all.
+struct PostingBlock {
+    uint8_t bit_width_{0};
+    uint8_t count_{0};
+    std::vector<uint64_t> packed_;
+};
+
+class PostingList {
+   public:
+    static constexpr size_t kBlockSize = 128;
+
+    explicit PostingList(uint8_t max_level,
+                         unsigned int seed = std::random_device{}())
+        : max_level_(max_level),
+          header_(std::make_unique<BlockNode>(0, PostingBlock{}, max_level_)),
+          gen_(seed),
+          distribution_(0.5) {}
+
+    PostingList(const PostingList&) = delete;
+    PostingList& operator=(const PostingList&) = delete;
+
+    bool insert(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto preds = find_predecessors(id);
+        auto* nxt = preds[0]->forward_[0].get();
+        if (nxt && nxt->key_ == id) return false;
+
+        BlockNode* block = preds[0] != header_.get() ? preds[0] : nxt;
+        if (!block) {
+            insert_new_block({id}, preds);
+            ++element_count_;
+            return true;
+        }
+
+        decode_block(block, ids_);
+        auto pos = std::lower_bound(ids_.begin(), ids_.end(), id);
+        if (pos != ids_.end() && *pos == id) return false;
+        ids_.insert(pos, id);
+        ++element_count_;
+
+        if (ids_.size() <= kBlockSize) {
+            encode_block(block, ids_.begin(), ids_.end());
+            return true;
+        }
+        auto mid = ids_.begin() + ids_.size() / 2;
+        encode_block(block, ids_.begin(), mid);
+        std::vector<uint64_t> upper(mid, ids_.end());
+        insert_new_block(upper, find_predecessors(upper.front()));
+        return true;
+    }
+
+    bool contains(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto* block = find_block(id);
+        if (!block) return false;
+        if (block->key_ == id) return true;
+        decode_block(block, ids_);
+        return std::binary_search(ids_.begin(), ids_.end(), id);
+    }
+
+    bool remove(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto* block = find_block(id);
+        if (!block) return false;
+        decode_block(block, ids_);
+        auto pos = std::lower_bound(ids_.begin(), ids_.end(), id);
+        if (pos == ids_.end() || *pos != id) return false;
+        ids_.erase(pos);
+        --element_count_;
+
+        if (ids_.empty()) {
+            delete_block(block);
+            return true;
+        }
+        absorb_next_on_underflow(block);
+        encode_block(block, ids_.begin(), ids_.end());
+        return true;
+    }
+
+    std::vector<uint64_t> to_vector() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<uint64_t> out;
+        out.reserve(element_count_);
+        for (auto* cur = header_->forward_[0].get(); cur;
+             cur = cur->forward_[0].get()) {
+            decode_block(cur, ids_);
+            out.insert(out.end(), ids_.begin(), ids_.end());
+        }
+        return out;
+    }
+
+    size_t size() const { return element_count_; }
+    bool empty() const { return element_count_ == 0; }
+
+    // Blocks whose id range cannot overlap the other side are skipped through
+    // the towers without being decoded.
+    friend void set_intersection(PostingList& lhs, PostingList& rhs,
+                                 std::vector<uint64_t>& out) {
+        if (&lhs == &rhs) {
+            out = lhs.to_vector();
+            return;
+        }
+        std::scoped_lock lock(lhs.mutex_, rhs.mutex_);
+        auto* a = lhs.header_->forward_[0].get();
+        auto* b = rhs.header_->forward_[0].get();
+        while (a && b) {
+            auto* a_next = a->forward_[0].get();
+            auto* b_next = b->forward_[0].get();
+            if (a_next && a_next->key_ <= b->key_) {
+                a = lhs.find_block(b->key_);
+                continue;
+            }
+            if (b_next && b_next->key_ <= a->key_) {
+                b = rhs.find_block(a->key_);
+                continue;
+            }
+
+            decode_block(a, lhs.ids_);
+            decode_block(b, rhs.ids_);
+            intersect_sorted(lhs.ids_, rhs.ids_, out);
+
+            if (!a_next || (b_next && b_next->key_ < a_next->key_)) {
+                b = b_next;
+            } else if (!b_next || a_next->key_ < b_next->key_) {
+                a = a_next;
+            } else {
+                a = a_next;
+                b = b_next;
+            }
+        }
+    }
+
+   private:
+    using BlockNode = Node<uint64_t, PostingBlock>;
+    using PredVec = std::vector<BlockNode*>;
+
+    static uint8_t bit_width(uint64_t v) {
+        uint8_t bits = 0;
+        while (v) {
+            ++bits;
+            v >>= 1;
+        }
+        return bits;
+    }
+
+    template <typename It>
+    static void encode_block(BlockNode* node, It first, It last) {
+        auto& block = node->value_;
+        node->key_ = *first;
+        block.count_ = static_cast<uint8_t>(last - first);
+
+        uint64_t widest = 0;
+        for (It cur = first + 1; cur < last; ++cur)
+            widest |= *cur - *(cur - 1) - 1;
+        block.bit_width_ = bit_width(widest);
+
+        size_t total_bits = size_t{block.bit_width_} * (block.count_ - 1);
+        block.packed_.assign((total_bits + 63) / 64, 0);
+        block.packed_.shrink_to_fit();
+        if (!block.bit_width_) return;
+
+        size_t bit = 0;
+        for (It cur = first + 1; cur < last; ++cur, bit += block.bit_width_) {
+            uint64_t delta = *cur - *(cur - 1) - 1;
+            size_t word = bit / 64, offset = bit % 64;
+            block.packed_[word] |= delta << offset;
+            if (offset + block.bit_width_ > 64)
+                block.packed_[word + 1] |= delta >> (64 - offset);
+        }
+    }
+
+    // Fixed-width unpack followed by a separate prefix-sum pass. Both loops
+    // are scalar: the header stays portable and carries no SIMD intrinsics.
+    // GCC vectorizes the unpack only at -O3 with gathers (e.g. AVX2), and the
+    // prefix sum, a loop-carried dependence, not at all.
+    static void decode_block(const BlockNode* node, std::vector<uint64_t>& ids) {
+        const auto& block = node->value_;
+        ids.resize(block.count_);
+        ids[0] = node->key_;
+        const uint8_t bits = block.bit_width_;
+        const uint64_t mask = bits == 64 ? ~uint64_t{0} : (uint64_t{1} << bits) - 1;
+
+        for (size_t i = 1; i < block.count_; ++i) {
+            uint64_t delta = 0;
+            if (bits) {
+                size_t bit = (i - 1) * bits;
+                size_t word = bit / 64, offset = bit % 64;
+                delta = block.packed_[word] >> offset;
+                if (offset + bits > 64) delta |= block.packed_[word + 1] << (64 - offset);
+            }
+            ids[i] = (delta & mask) + 1;
+        }
+        for (size_t i = 1; i < block.count_; ++i) ids[i] += ids[i - 1];
+    }
+
+    static void intersect_sorted(const std::vector<uint64_t>& a,
+                                 const std::vector<uint64_t>& b,
+                                 std::vector<uint64_t>& out) {
+        size_t i = 0, j = 0;
+        while (i < a.size() && j < b.size()) {
+            uint64_t x = a[i], y = b[j];
+            if (x == y) out.push_back(x);
+            i += x <= y;
+            j += y <= x;
+        }
+    }
+
+    BlockNode* find_block(uint64_t id) {
+        BlockNode* cur = header_.get();
+        for (int i = current_max_level_; i >= 0; --i) {
+            while (cur->forward_[i] && cur->forward_[i]->key_ <= id)
+                cur = cur->forward_[i].get();
+        }
+        return cur == header_.get() ? nullptr : cur;
+    }
+
+    PredVec find_predecessors(uint64_t id) {
+        PredVec preds(max_level_ + 1, nullptr);
+        BlockNode* cur = header_.get();
+        for (int i = current_max_level_; i >= 0; --i) {
+            while (cur->forward_[i] && cur->forward_[i]->key_ < id)
+                cur = cur->forward_[i].get();
+            preds[i] = cur;
+        }
+        return preds;
+    }
+
+    void insert_new_block(const std::vector<uint64_t>& ids, PredVec preds) {
+        uint8_t lvl = generate_random_level();
+        if (lvl > current_max_level_) {
+            for (uint8_t i = current_max_level_ + 1; i <= lvl; ++i)
+                preds[i] = header_.get();
+            current_max_level_ = lvl;
+        }
+
+        auto node = std::make_shared<BlockNode>(ids.front(), PostingBlock{}, lvl);
+        encode_block(node.get(), ids.begin(), ids.end());
+        for (uint8_t i = 0; i <= lvl; ++i) {
+            node->forward_[i] = preds[i]->forward_[i];
+            preds[i]->forward_[i] = node;
+        }
+    }
+
+    void delete_block(BlockNode* node) {
+        auto preds = find_predecessors(node->key_);
+        for (uint8_t i = 0; i <= current_max_level_; ++i) {
+            if (preds[i]->forward_[i].get() == node)
+                preds[i]->forward_[i] = node->forward_[i];
+        }
+        while (current_max_level_ > 0 && !header_->forward_[current_max_level_])
+            --current_max_level_;
+    }
+
+    // Folds the following block into ids_ when both fit in one block, so
+    // deletes do not leave long chains of nearly empty blocks behind.
+    void absorb_next_on_underflow(BlockNode* block) {
+        auto* nxt = block->forward_[0].get();
+        if (!nxt || ids_.size() >= kBlockSize / 4 ||
+            ids_.size() + nxt->value_.count_ > kBlockSize)
+            return;
+        std::vector<uint64_t> tail;
+        decode_block(nxt, tail);
+        ids_.insert(ids_.end(), tail.begin(), tail.end());
+        delete_block(nxt);
+    }
+
+    uint8_t generate_random_level() {
+        uint8_t lvl = 0;
+        while (distribution_(gen_) && lvl < max_level_) ++lvl;
+        return lvl;
+    }
+
+    uint8_t max_level_;
+    uint8_t current_max_level_{0};
+    std::unique_ptr<BlockNode> header_;
+    size_t element_count_{0};
+    std::vector<uint64_t> ids_;
+
+    mutable std::mutex mutex_;
+    std::mt19937 gen_;
+    std::bernoulli_distribution distribution_;
+};
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_POSTING_LIST_H
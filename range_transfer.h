@@ -0,0 +1,294 @@
+#ifndef MOMU_RANGE_TRANSFER_H
+#define MOMU_RANGE_TRANSFER_H
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "codec.h"
+#include "skip_list.h"
+
+namespace momu {
+namespace skip_list {
+
+// Stream format: a sequence of blocks, each a 16-byte header followed by
+// the payload, and ended by an empty block. The header is a fixed32 payload
+// size, a fixed32 entry count, a fixed32 CRC-32C of the payload and a
+// fixed32 CRC-32C of the preceding 12 header bytes, so the framing is
+// verified before the size is trusted. Payloads are at most
+// kMaxRangeBlockBytes. An entry is varint
+// shared key bytes, varint unshared key bytes, varint value size, the
+// unshared key suffix and the value. Keys share a prefix only with the
+// previous key of the same block, so blocks decode on their own.
+constexpr size_t kMaxRangeBlockBytes = size_t{64} << 20;
+constexpr size_t kRangeBlockHeaderBytes = 16;
+
+template <typename K, typename V, typename KeyCodec = Codec<K>,
+          typename ValueCodec = Codec<V>>
+class RangeExporter {
+   public:
+    explicit RangeExporter(SkipList<K, V>& list, size_t block_size = 64 * 1024,
+                           bool prefix_compression = true)
+        : list_(list), block_size_(block_size), prefix_compression_(prefix_compression) {}
+
+    // Writes the entries with keys in [from, to) to fd. The list is scanned
+    // one block at a time and unlocked while a block is written, so memory
+    // stays at about one block whatever the size of the range. Fails if a
+    // block would exceed kMaxRangeBlockBytes, e.g. for a huge value.
+    bool write(const K& from, const K& to, int fd) {
+        std::optional<K> last;
+        while (true) {
+            bool done = true;
+            reset_block();
+            list_.scan(last ? *last : from, [&](const K& key, const V& value) {
+                if (last && !(*last < key)) return true;
+                if (!(key < to)) return false;
+                if (count_ > 0 && payload_.size() >= block_size_) {
+                    done = false;
+                    return false;
+                }
+                append_entry(key, value);
+                last = key;
+                return true;
+            });
+            if (count_ > 0 && !write_block(fd)) return false;
+            if (done) break;
+        }
+        reset_block();
+        return write_block(fd);
+    }
+
+   private:
+    void reset_block() {
+        payload_.clear();
+        previous_key_.clear();
+        count_ = 0;
+    }
+
+    void append_entry(const K& key, const V& value) {
+        key_.clear();
+        KeyCodec::encode(key, key_);
+        value_.clear();
+        ValueCodec::encode(value, value_);
+
+        size_t shared = 0;
+        if (prefix_compression_) {
+            size_t limit = std::min(key_.size(), previous_key_.size());
+            while (shared < limit && key_[shared] == previous_key_[shared]) ++shared;
+        }
+        put_varint32(payload_, static_cast<uint32_t>(shared));
+        put_varint32(payload_, static_cast<uint32_t>(key_.size() - shared));
+        put_varint32(payload_, static_cast<uint32_t>(value_.size()));
+        payload_.append(key_, shared, std::string::npos);
+        payload_ += value_;
+        previous_key_.swap(key_);
+        ++count_;
+    }
+
+    bool write_block(int fd) {
+        if (payload_.size() > kMaxRangeBlockBytes) return false;
+        header_.clear();
+        put_fixed32(header_, static_cast<uint32_t>(payload_.size()));
+        put_fixed32(header_, count_);
+        put_fixed32(header_, crc32c(payload_.data(), payload_.size()));
+        put_fixed32(header_, crc32c(header_.data(), header_.size()));
+        return write_all(fd, header_) && write_all(fd, payload_);
+    }
+
+    static bool write_all(int fd, const std::string& data) {
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    SkipList<K, V>& list_;
+    const size_t block_size_;
+    const bool prefix_compression_;
+    std::string header_;
+    std::string payload_;
+    std::string key_;
+    std::string value_;
+    std::string previous_key_;
+    uint32_t count_{0};
+};
+
+// Reads a RangeExporter stream one block at a time, checking each CRC.
+class RangeBlockReader {
+   public:
+    enum class Status { kBlock, kEnd, kCorrupt, kError };
+
+    explicit RangeBlockReader(int fd) : fd_(fd) {}
+
+    // kCorrupt means the payload's CRC did not match; the payload has been
+    // consumed and the next block can still be read. kError means the
+    // stream failed or was truncated, or a header is corrupt, after which
+    // the next block cannot be found.
+    Status next() {
+        char header[kRangeBlockHeaderBytes];
+        if (!read_exact(header, sizeof(header))) return Status::kError;
+        if (crc32c(header, 12) != get_fixed32(header + 12)) return Status::kError;
+        uint32_t size = get_fixed32(header);
+        if (size > kMaxRangeBlockBytes) return Status::kError;
+        count_ = get_fixed32(header + 4);
+        payload_.resize(size);
+        if (!read_exact(payload_.data(), size)) return Status::kError;
+        if (crc32c(payload_.data(), size) != get_fixed32(header + 8)) return Status::kCorrupt;
+        return size == 0 && count_ == 0 ? Status::kEnd : Status::kBlock;
+    }
+
+    // Calls fn(key_bytes, value_data, value_size) for each entry of the
+    // current block; false if the entries are malformed or fn refuses one.
+    template <typename Fn>
+    bool decode(Fn&& fn) {
+        const char* p = payload_.data();
+        const char* limit = p + payload_.size();
+        key_.clear();
+        for (uint32_t i = 0; i < count_; ++i) {
+            uint32_t shared, unshared, value_size;
+            if (!get_varint32(p, limit, shared) || !get_varint32(p, limit, unshared) ||
+                !get_varint32(p, limit, value_size))
+                return false;
+            if (shared > key_.size() || static_cast<size_t>(limit - p) < unshared ||
+                static_cast<size_t>(limit - p) - unshared < value_size)
+                return false;
+            key_.resize(shared);
+            key_.append(p, unshared);
+            p += unshared;
+            if (!fn(key_, p, value_size)) return false;
+            p += value_size;
+        }
+        return p == limit;
+    }
+
+    uint32_t count() const { return count_; }
+
+   private:
+    bool read_exact(char* data, size_t size) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = ::read(fd_, data + done, size - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    const int fd_;
+    std::string payload_;
+    std::string key_;
+    uint32_t count_{0};
+};
+
+// Reads a RangeExporter stream into a list. Entries arrive in key order, so
+// importing into an empty list, or past its last key, takes the append path
+// of put. With skip_corrupt set, blocks failing their CRC are counted and
+// skipped rather than ending the import, salvaging the rest of the range.
+template <typename K, typename V, typename KeyCodec = Codec<K>,
+          typename ValueCodec = Codec<V>>
+class RangeImporter {
+   public:
+    explicit RangeImporter(SkipList<K, V>& list, bool skip_corrupt = false)
+        : list_(list), skip_corrupt_(skip_corrupt) {}
+
+    // Returns false on a read error or a malformed or truncated stream.
+    bool read(int fd) {
+        RangeBlockReader reader(fd);
+        while (true) {
+            switch (reader.next()) {
+                case RangeBlockReader::Status::kEnd:
+                    return true;
+                case RangeBlockReader::Status::kError:
+                    return false;
+                case RangeBlockReader::Status::kCorrupt:
+                    ++corrupt_blocks_;
+                    if (!skip_corrupt_) return false;
+                    break;
+                case RangeBlockReader::Status::kBlock:
+                    if (!reader.decode([this](const std::string& key_bytes,
+                                              const char* value_data, size_t value_size) {
+                            return apply(key_bytes, value_data, value_size);
+                        }))
+                        return false;
+                    break;
+            }
+        }
+    }
+
+    size_t imported() const { return imported_; }
+    size_t corrupt_blocks() const { return corrupt_blocks_; }
+
+   private:
+    bool apply(const std::string& key_bytes, const char* value_data, size_t value_size) {
+        K key;
+        V value;
+        if (!KeyCodec::decode(key_bytes.data(), key_bytes.size(), key) ||
+            !ValueCodec::decode(value_data, value_size, value))
+            return false;
+        list_.put(key, value);
+        ++imported_;
+        return true;
+    }
+
+    SkipList<K, V>& list_;
+    const bool skip_corrupt_;
+    size_t imported_{0};
+    size_t corrupt_blocks_{0};
+};
+
+// Validates a persisted range image without loading it: every block's CRC
+// and entry framing, and the end marker.
+class RangeImageChecker {
+   public:
+    // Returns true if the whole image is intact.
+    bool check(int fd) {
+        RangeBlockReader reader(fd);
+        while (true) {
+            switch (reader.next()) {
+                case RangeBlockReader::Status::kEnd:
+                    complete_ = true;
+                    return corrupt_blocks_ == 0;
+                case RangeBlockReader::Status::kError:
+                    return false;
+                case RangeBlockReader::Status::kCorrupt:
+                    ++corrupt_blocks_;
+                    break;
+                case RangeBlockReader::Status::kBlock:
+                    ++blocks_;
+                    if (reader.decode([](const std::string&, const char*, size_t) {
+                            return true;
+                        }))
+                        entries_ += reader.count();
+                    else
+                        ++corrupt_blocks_;
+                    break;
+            }
+        }
+    }
+
+    size_t blocks() const { return blocks_; }
+    size_t entries() const { return entries_; }
+    size_t corrupt_blocks() const { return corrupt_blocks_; }
+    // Whether the end marker was reached, i.e. the image is not truncated.
+    bool complete() const { return complete_; }
+
+   private:
+    size_t blocks_{0};
+    size_t entries_{0};
+    size_t corrupt_blocks_{0};
+    bool complete_{false};
+};
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_RANGE_TRANSFER_H
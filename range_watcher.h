@@ -0,0 +1,189 @@
+#ifndef MOMU_RANGE_WATCHER_H
+#define MOMU_RANGE_WATCHER_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "interval_skip_list.h"
+#include "skip_list.h"
+
+namespace momu {
+namespace skip_list {
+
+template <typename K, typename V>
+struct WatchEvent {
+    Mutation op_;
+    K key_;
+    std::optional<V> value_;
+};
+
+// Delivers put/remove events for keys in [from, to] to each subscriber on
+// its own thread. Events are queued in a bounded per-subscriber queue; when
+// a subscriber falls behind, new events for it are dropped and counted
+// rather than blocking the mutating thread.
+template <typename K, typename V>
+class RangeWatcher {
+   public:
+    using Callback = std::function<void(const WatchEvent<K, V>&)>;
+
+    explicit RangeWatcher(SkipList<K, V>& list, size_t queue_capacity = 1024,
+                          uint8_t max_level = 16)
+        : list_(list), queue_capacity_(queue_capacity), index_(max_level) {
+        listener_id_ = list_.add_listener(
+            [this](Mutation op, const K& key, const V* value) {
+                dispatch(op, key, value);
+            });
+    }
+
+    RangeWatcher(const RangeWatcher&) = delete;
+    RangeWatcher& operator=(const RangeWatcher&) = delete;
+
+    ~RangeWatcher() {
+        list_.remove_listener(listener_id_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : subscriptions_) entry.second->stop();
+    }
+
+    size_t watch(const K& from, const K& to, Callback callback) {
+        auto sub = std::make_shared<Subscription>(from, to, std::move(callback),
+                                                  queue_capacity_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto group = index_.get(from);
+        Group members = group ? std::move(group->value_) : Group{};
+        members.push_back(sub);
+        index_group(from, members);
+        subscriptions_.emplace(++last_id_, sub);
+        return last_id_;
+    }
+
+    // Must not be called from a subscriber's own callback.
+    bool unwatch(size_t id) {
+        std::shared_ptr<Subscription> sub;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = subscriptions_.find(id);
+            if (it == subscriptions_.end()) return false;
+            sub = std::move(it->second);
+            subscriptions_.erase(it);
+
+            auto group = index_.get(sub->from_);
+            Group members = std::move(group->value_);
+            members.erase(std::find(members.begin(), members.end(), sub));
+            if (members.empty())
+                index_.remove(sub->from_);
+            else
+                index_group(sub->from_, members);
+        }
+        sub->stop();
+        return true;
+    }
+
+    size_t dropped(size_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = subscriptions_.find(id);
+        return it == subscriptions_.end() ? 0 : it->second->dropped();
+    }
+
+   private:
+    struct Subscription {
+        Subscription(const K& from, const K& to, Callback callback,
+                     size_t capacity)
+            : from_(from), to_(to), callback_(std::move(callback)),
+              capacity_(capacity), worker_([this] { run(); }) {}
+
+        bool covers(const K& key) const { return !(key < from_) && !(to_ < key); }
+
+        void push(WatchEvent<K, V> event) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopped_ || queue_.size() >= capacity_) {
+                ++dropped_;
+                return;
+            }
+            queue_.push_back(std::move(event));
+            ready_.notify_one();
+        }
+
+        size_t dropped() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return dropped_;
+        }
+
+        // Delivers whatever is already queued, then joins the worker.
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopped_ = true;
+                ready_.notify_one();
+            }
+            worker_.join();
+        }
+
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (true) {
+                ready_.wait(lock, [this] { return stopped_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+                auto event = std::move(queue_.front());
+                queue_.pop_front();
+                lock.unlock();
+                callback_(event);
+                lock.lock();
+            }
+        }
+
+        const K from_;
+        const K to_;
+        Callback callback_;
+        const size_t capacity_;
+
+        std::mutex mutex_;
+        std::condition_variable ready_;
+        std::deque<WatchEvent<K, V>> queue_;
+        bool stopped_{false};
+        size_t dropped_{0};
+        std::thread worker_;
+    };
+
+    // Subscriptions sharing a start key share one interval, whose end is the
+    // widest of theirs; each member re-checks its own range on delivery.
+    using Group = std::vector<std::shared_ptr<Subscription>>;
+
+    void index_group(const K& from, const Group& members) {
+        K to = members.front()->to_;
+        for (const auto& sub : members) {
+            if (to < sub->to_) to = sub->to_;
+        }
+        index_.put(from, to, members);
+    }
+
+    void dispatch(Mutation op, const K& key, const V* value) {
+        for (const auto& group : index_.stab(key)) {
+            for (const auto& sub : group.value_) {
+                if (!sub->covers(key)) continue;
+                sub->push({op, key, value ? std::optional<V>(*value) : std::nullopt});
+            }
+        }
+    }
+
+    SkipList<K, V>& list_;
+    const size_t queue_capacity_;
+    size_t listener_id_{0};
+
+    IntervalSkipList<K, Group> index_;
+    std::unordered_map<size_t, std::shared_ptr<Subscription>> subscriptions_;
+    size_t last_id_{0};
+    std::mutex mutex_;
+};
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_RANGE_WATCHER_H
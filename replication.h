@@ -0,0 +1,356 @@
+#ifndef MOMU_REPLICATION_H
+#define MOMU_REPLICATION_H
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "codec.h"
+#include "skip_list.h"
+
+namespace momu {
+namespace skip_list {
+
+// Wire format: a stream of frames, each one op byte followed by a
+// length-prefixed key and, for puts, a length-prefixed value. A follower
+// first receives a snapshot as puts, then kSnapshotEnd, then the live tail.
+enum class ReplicationOp : uint8_t { kPut = 0, kRemove = 1, kSnapshotEnd = 2 };
+
+template <typename KeyCodec, typename ValueCodec, typename K, typename V>
+std::string encode_mutation(Mutation op, const K& key, const V* value) {
+    std::string frame;
+    frame += static_cast<char>(op == Mutation::kPut ? ReplicationOp::kPut
+                                                    : ReplicationOp::kRemove);
+    put_length_prefixed<KeyCodec>(frame, key);
+    if (value) put_length_prefixed<ValueCodec>(frame, *value);
+    return frame;
+}
+
+// Ships every mutation of a list to followers over byte streams (pipes or
+// sockets). Frames are encoded once, queued per follower and written in
+// batches by one sender thread per follower, which never waits for acks. A
+// follower whose queue would grow past max_queued_bytes, not counting its
+// snapshot, is too slow to keep up and is dropped.
+template <typename K, typename V, typename KeyCodec = Codec<K>,
+          typename ValueCodec = Codec<V>>
+class ReplicationPrimary {
+   public:
+    static constexpr size_t kDefaultMaxQueuedBytes = 64 << 20;
+
+    explicit ReplicationPrimary(SkipList<K, V>& list,
+                                size_t max_queued_bytes = kDefaultMaxQueuedBytes)
+        : list_(list), max_queued_bytes_(max_queued_bytes) {
+        listener_id_ = list_.add_listener(
+            [this](Mutation op, const K& key, const V* value) {
+                broadcast(encode(op, key, value));
+            });
+    }
+
+    ReplicationPrimary(const ReplicationPrimary&) = delete;
+    ReplicationPrimary& operator=(const ReplicationPrimary&) = delete;
+
+    // Flushes what is already queued to every follower that is still
+    // reading before returning; see Follower::stop for those that are not.
+    ~ReplicationPrimary() {
+        list_.remove_listener(listener_id_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& follower : followers_) follower->stop();
+        for (auto& follower : retired_) follower->stop();
+    }
+
+    // Starts streaming to fd, which the caller keeps owning; the primary only
+    // shuts a socket down if it has stalled when the primary is destroyed.
+    // The follower is registered before the snapshot is taken and its tail
+    // is held back until the snapshot is queued; replaying that tail on top
+    // of the snapshot converges because puts and removes are last-writer-wins.
+    void add_follower(int fd) {
+        auto follower = std::make_shared<Follower>(fd, max_queued_bytes_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            followers_.push_back(follower);
+        }
+
+        std::string snapshot;
+        list_.for_each([&snapshot](const K& key, const V& value) {
+            snapshot += encode(Mutation::kPut, key, &value);
+        });
+        snapshot += static_cast<char>(ReplicationOp::kSnapshotEnd);
+        follower->finish_catch_up(std::move(snapshot));
+    }
+
+    // Followers whose stream failed are dropped on the next mutation.
+    size_t follower_count() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return followers_.size();
+    }
+
+   private:
+    class Follower {
+       public:
+        Follower(int fd, size_t max_queued_bytes)
+            : fd_(fd), max_queued_bytes_(max_queued_bytes), sender_([this] { run(); }) {}
+
+        void enqueue(const std::string& frame) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (failed()) return;
+            std::string& queue = catching_up_ ? backlog_ : outbox_;
+            if (queue.size() + frame.size() > max_queued_bytes_) {
+                failed_.store(true, std::memory_order_relaxed);
+                outbox_.clear();
+                backlog_.clear();
+            } else {
+                queue += frame;
+            }
+            ready_.notify_one();
+        }
+
+        void finish_catch_up(std::string snapshot) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (failed()) return;
+            snapshot_ = std::move(snapshot);
+            outbox_.swap(backlog_);
+            catching_up_ = false;
+            ready_.notify_one();
+        }
+
+        bool failed() const { return failed_.load(std::memory_order_relaxed); }
+        bool exited() const { return exited_.load(std::memory_order_acquire); }
+
+        // Lets the sender flush for as long as the peer keeps reading. A peer
+        // that stops reading would leave it blocked in send() forever, so
+        // after kStallTimeout without progress, or at once if the follower
+        // was dropped, the socket is shut down, which fails the send. A pipe
+        // cannot be unblocked this way; its reader must not stall.
+        void stop() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stopped_ = true;
+            ready_.notify_one();
+            uint64_t seen = written_.load(std::memory_order_relaxed);
+            while (!failed() &&
+                   !exited_cv_.wait_for(lock, kStallTimeout, [this] { return exited(); })) {
+                uint64_t now = written_.load(std::memory_order_relaxed);
+                if (now == seen) break;
+                seen = now;
+            }
+            if (!exited()) ::shutdown(fd_, SHUT_RDWR);
+            lock.unlock();
+            sender_.join();
+        }
+
+       private:
+        static constexpr std::chrono::seconds kStallTimeout{1};
+        // A blocking send returns only once all of it is written, so batches
+        // go out in chunks for stop() to see a slow peer making progress.
+        static constexpr size_t kWriteChunk = 64 << 10;
+
+        void run() {
+            // A pipe whose reader is gone raises SIGPIPE on write, which
+            // would kill the process. Keep it blocked on this thread and
+            // discard it; the write fails with EPIPE instead.
+            sigset_t sigpipe;
+            sigemptyset(&sigpipe);
+            sigaddset(&sigpipe, SIGPIPE);
+            pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+
+            std::string batch;
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (true) {
+                ready_.wait(lock, [this] {
+                    return stopped_ || failed() || !snapshot_.empty() || !outbox_.empty();
+                });
+                if (failed()) break;
+                if (!snapshot_.empty())
+                    batch.swap(snapshot_);
+                else if (!outbox_.empty())
+                    batch.swap(outbox_);
+                else
+                    break;
+                lock.unlock();
+                bool ok = write_all(batch, sigpipe);
+                batch.clear();
+                lock.lock();
+                if (!ok) {
+                    failed_.store(true, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            exited_.store(true, std::memory_order_release);
+            exited_cv_.notify_all();
+        }
+
+        bool write_all(const std::string& data, const sigset_t& sigpipe) {
+            size_t done = 0;
+            while (done < data.size()) {
+                size_t len = std::min(data.size() - done, kWriteChunk);
+                ssize_t n = ::send(fd_, data.data() + done, len, MSG_NOSIGNAL);
+                if (n < 0 && errno == ENOTSOCK) {
+                    n = ::write(fd_, data.data() + done, len);
+                    if (n < 0 && errno == EPIPE) {
+                        timespec zero{};
+                        sigtimedwait(&sigpipe, nullptr, &zero);
+                    }
+                }
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                done += static_cast<size_t>(n);
+                written_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        const int fd_;
+        const size_t max_queued_bytes_;
+        std::mutex mutex_;
+        std::condition_variable ready_;
+        std::condition_variable exited_cv_;
+        std::string snapshot_;
+        std::string outbox_;
+        std::string backlog_;
+        bool catching_up_{true};
+        bool stopped_{false};
+        std::atomic<bool> failed_{false};
+        std::atomic<bool> exited_{false};
+        std::atomic<uint64_t> written_{0};
+        std::thread sender_;
+    };
+
+    static std::string encode(Mutation op, const K& key, const V* value) {
+        return encode_mutation<KeyCodec, ValueCodec>(op, key, value);
+    }
+
+    // A dropped follower's sender may still be blocked in a write, and this
+    // runs under the list's lock, so it is joined only once it has exited.
+    void broadcast(const std::string& frame) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = followers_.begin(); it != followers_.end();) {
+            if ((*it)->failed()) {
+                retired_.push_back(std::move(*it));
+                it = followers_.erase(it);
+                continue;
+            }
+            (*it)->enqueue(frame);
+            ++it;
+        }
+        for (auto it = retired_.begin(); it != retired_.end();) {
+            if (!(*it)->exited()) {
+                ++it;
+                continue;
+            }
+            (*it)->stop();
+            it = retired_.erase(it);
+        }
+    }
+
+    SkipList<K, V>& list_;
+    const size_t max_queued_bytes_;
+    size_t listener_id_{0};
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<Follower>> followers_;
+    std::vector<std::shared_ptr<Follower>> retired_;
+};
+
+// Applies a primary's stream to a local list. The list is expected to start
+// empty; it then mirrors the primary once the snapshot has been applied.
+template <typename K, typename V, typename KeyCodec = Codec<K>,
+          typename ValueCodec = Codec<V>>
+class ReplicationFollower {
+   public:
+    ReplicationFollower(SkipList<K, V>& list, int fd) : list_(list), fd_(fd) {}
+
+    ReplicationFollower(const ReplicationFollower&) = delete;
+    ReplicationFollower& operator=(const ReplicationFollower&) = delete;
+
+    // Reads and applies frames until the stream ends. Returns false on a
+    // read error or a malformed frame.
+    bool run() {
+        std::string buffer;
+        char chunk[64 * 1024];
+        while (true) {
+            ssize_t n = ::read(fd_, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) return false;
+            if (n == 0) return buffer.empty();
+            buffer.append(chunk, static_cast<size_t>(n));
+
+            size_t consumed = 0;
+            while (true) {
+                size_t used = apply_frame(buffer.data() + consumed,
+                                          buffer.size() - consumed);
+                if (used == kMalformed) return false;
+                if (used == 0) break;
+                consumed += used;
+            }
+            buffer.erase(0, consumed);
+        }
+    }
+
+    bool caught_up() const { return caught_up_.load(std::memory_order_acquire); }
+
+   private:
+    static constexpr size_t kMalformed = static_cast<size_t>(-1);
+
+    // Returns the frame size, 0 when the frame is still incomplete, or
+    // kMalformed.
+    size_t apply_frame(const char* data, size_t size) {
+        if (size < 1) return 0;
+        auto op = static_cast<ReplicationOp>(data[0]);
+        if (op == ReplicationOp::kSnapshotEnd) {
+            caught_up_.store(true, std::memory_order_release);
+            return 1;
+        }
+        if (op != ReplicationOp::kPut && op != ReplicationOp::kRemove)
+            return kMalformed;
+
+        size_t pos = 1;
+        const char* key_data;
+        uint32_t key_size;
+        if (!read_field(data, size, pos, key_data, key_size)) return 0;
+        K key;
+        if (!KeyCodec::decode(key_data, key_size, key)) return kMalformed;
+
+        if (op == ReplicationOp::kRemove) {
+            list_.remove(key);
+            return pos;
+        }
+        const char* value_data;
+        uint32_t value_size;
+        if (!read_field(data, size, pos, value_data, value_size)) return 0;
+        V value;
+        if (!ValueCodec::decode(value_data, value_size, value)) return kMalformed;
+        list_.put(key, value);
+        return pos;
+    }
+
+    static bool read_field(const char* data, size_t size, size_t& pos,
+                           const char*& field, uint32_t& field_size) {
+        if (size - pos < 4) return false;
+        field_size = get_fixed32(data + pos);
+        if (size - pos - 4 < field_size) return false;
+        field = data + pos + 4;
+        pos += 4 + field_size;
+        return true;
+    }
+
+    SkipList<K, V>& list_;
+    const int fd_;
+    std::atomic<bool> caught_up_{false};
+};
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_REPLICATION_H
@@ -0,0 +1,574 @@
+#ifndef MOMU_RESP_SERVER_H
+#define MOMU_RESP_SERVER_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "skip_list.h"
+
+namespace momu {
+namespace skip_list {
+
+// A small Redis-protocol server over sharded SkipLists, meant for driving
+// the lists end to end with stock tools such as redis-benchmark. It runs one
+// epoll loop per thread on SO_REUSEPORT listeners; requests are parsed in
+// place as string_views into the connection buffer and pipelined requests
+// are answered with a single write.
+//
+// Supported: PING, GET, SET, DEL, EXISTS, DBSIZE, SCAN cursor [COUNT n],
+// ZADD key score member [score member ...], ZRANGE key start stop
+// [WITHSCORES]. COMMAND and CONFIG reply with an empty array so that
+// clients probing them at startup keep going.
+//
+// It listens on bind_address, an IPv4 address, loopback by default; pass
+// "0.0.0.0" to serve every interface. There is no authentication.
+class RespServer {
+   public:
+    explicit RespServer(uint16_t port,
+                        size_t loops = std::thread::hardware_concurrency(),
+                        size_t shards = std::thread::hardware_concurrency(),
+                        uint8_t max_level = 16, std::string bind_address = "127.0.0.1")
+        : requested_port_(port),
+          bind_address_(std::move(bind_address)),
+          loop_count_(loops ? loops : 1) {
+        for (size_t i = 0; i < (shards ? shards : 1); ++i)
+            shards_.push_back(std::make_unique<Shard>(max_level));
+    }
+
+    RespServer(const RespServer&) = delete;
+    RespServer& operator=(const RespServer&) = delete;
+
+    ~RespServer() { stop(); }
+
+    // Binds the listeners and starts the event loops. Returns false if the
+    // address is not a valid IPv4 address or the port cannot be bound.
+    bool start() {
+        uint16_t port = requested_port_;
+        for (size_t i = 0; i < loop_count_; ++i) {
+            auto loop = std::make_unique<EventLoop>(*this);
+            if (!loop->listen(bind_address_, port)) {
+                stop();
+                return false;
+            }
+            port = loop->port();
+            loops_.push_back(std::move(loop));
+        }
+        bound_port_ = port;
+        for (auto& loop : loops_) loop->start();
+        return true;
+    }
+
+    void stop() {
+        for (auto& loop : loops_) loop->stop();
+        loops_.clear();
+    }
+
+    uint16_t port() const { return bound_port_; }
+
+   private:
+    using Store = SkipList<std::string, std::string>;
+    using Score = std::pair<double, std::string>;
+
+    struct SortedSet {
+        explicit SortedSet(uint8_t max_level) : by_score_(max_level) {}
+
+        std::mutex mutex_;
+        std::unordered_map<std::string, double> scores_;
+        SkipList<Score, bool> by_score_;
+    };
+
+    struct Shard {
+        explicit Shard(uint8_t max_level) : max_level_(max_level), strings_(max_level) {}
+
+        SortedSet& sorted_set(std::string_view key) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& set = sorted_sets_[std::string(key)];
+            if (!set) set = std::make_unique<SortedSet>(max_level_);
+            return *set;
+        }
+
+        SortedSet* find_sorted_set(std::string_view key) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = sorted_sets_.find(std::string(key));
+            return it == sorted_sets_.end() ? nullptr : it->second.get();
+        }
+
+        const uint8_t max_level_;
+        Store strings_;
+        std::mutex mutex_;
+        std::unordered_map<std::string, std::unique_ptr<SortedSet>> sorted_sets_;
+    };
+
+    class EventLoop {
+       public:
+        explicit EventLoop(RespServer& server) : server_(server) {}
+
+        ~EventLoop() {
+            stop();
+            for (auto& entry : connections_) ::close(entry.first);
+            if (listen_fd_ >= 0) ::close(listen_fd_);
+            if (wake_fd_ >= 0) ::close(wake_fd_);
+            if (epoll_fd_ >= 0) ::close(epoll_fd_);
+        }
+
+        bool listen(const std::string& address, uint16_t port) {
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            if (::inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) return false;
+
+            listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            if (listen_fd_ < 0) return false;
+            int one = 1;
+            ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+            if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+                ::listen(listen_fd_, SOMAXCONN) < 0)
+                return false;
+
+            socklen_t len = sizeof(addr);
+            ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+            port_ = ntohs(addr.sin_port);
+
+            epoll_fd_ = ::epoll_create1(0);
+            wake_fd_ = ::eventfd(0, EFD_NONBLOCK);
+            return epoll_fd_ >= 0 && wake_fd_ >= 0 && watch(listen_fd_, EPOLLIN) &&
+                   watch(wake_fd_, EPOLLIN);
+        }
+
+        uint16_t port() const { return port_; }
+
+        void start() { thread_ = std::thread([this] { run(); }); }
+
+        void stop() {
+            if (!thread_.joinable()) return;
+            stopping_.store(true, std::memory_order_relaxed);
+            uint64_t one = 1;
+            [[maybe_unused]] auto n = ::write(wake_fd_, &one, sizeof(one));
+            thread_.join();
+        }
+
+       private:
+        struct Connection {
+            std::string in_;
+            std::string out_;
+            bool want_write_{false};
+        };
+
+        bool watch(int fd, uint32_t events) {
+            epoll_event ev{};
+            ev.events = events;
+            ev.data.fd = fd;
+            return ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == 0;
+        }
+
+        void run() {
+            epoll_event events[256];
+            while (!stopping_.load(std::memory_order_relaxed)) {
+                int n = ::epoll_wait(epoll_fd_, events, 256, -1);
+                for (int i = 0; i < n; ++i) {
+                    int fd = events[i].data.fd;
+                    if (fd == wake_fd_) continue;
+                    if (fd == listen_fd_) {
+                        accept_all();
+                        continue;
+                    }
+                    auto it = connections_.find(fd);
+                    if (it == connections_.end()) continue;
+                    bool alive = true;
+                    if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                        alive = on_readable(fd, it->second);
+                    if (alive) alive = flush(fd, it->second);
+                    if (!alive) {
+                        ::close(fd);
+                        connections_.erase(it);
+                    }
+                }
+            }
+        }
+
+        void accept_all() {
+            while (true) {
+                int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK);
+                if (fd < 0) return;
+                int one = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                if (!watch(fd, EPOLLIN)) {
+                    ::close(fd);
+                    continue;
+                }
+                connections_.emplace(fd, Connection{});
+            }
+        }
+
+        bool on_readable(int fd, Connection& conn) {
+            char chunk[16 * 1024];
+            while (true) {
+                ssize_t n = ::read(fd, chunk, sizeof(chunk));
+                if (n > 0) {
+                    conn.in_.append(chunk, static_cast<size_t>(n));
+                    continue;
+                }
+                if (n == 0) return false;
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return false;
+            }
+
+            size_t consumed = 0;
+            std::vector<std::string_view> args;
+            while (true) {
+                args.clear();
+                size_t used = parse_request(conn.in_, consumed, args);
+                if (used == kProtocolError) return false;
+                if (used == 0) break;
+                consumed += used;
+                server_.execute(args, conn.out_);
+            }
+            conn.in_.erase(0, consumed);
+            return true;
+        }
+
+        bool flush(int fd, Connection& conn) {
+            size_t done = 0;
+            while (done < conn.out_.size()) {
+                ssize_t n = ::send(fd, conn.out_.data() + done, conn.out_.size() - done,
+                                   MSG_NOSIGNAL);
+                if (n > 0) {
+                    done += static_cast<size_t>(n);
+                    continue;
+                }
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                return false;
+            }
+            conn.out_.erase(0, done);
+
+            bool want_write = !conn.out_.empty();
+            if (want_write != conn.want_write_) {
+                epoll_event ev{};
+                ev.events = EPOLLIN;
+                if (want_write) ev.events |= EPOLLOUT;
+                ev.data.fd = fd;
+                ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+                conn.want_write_ = want_write;
+            }
+            return true;
+        }
+
+        RespServer& server_;
+        int listen_fd_{-1};
+        int epoll_fd_{-1};
+        int wake_fd_{-1};
+        uint16_t port_{0};
+        std::atomic<bool> stopping_{false};
+        std::unordered_map<int, Connection> connections_;
+        std::thread thread_;
+    };
+
+    static constexpr size_t kProtocolError = static_cast<size_t>(-1);
+
+    // Parses one RESP array of bulk strings starting at pos. Returns its
+    // size, 0 if the request is still incomplete, or kProtocolError.
+    static size_t parse_request(std::string_view buf, size_t pos,
+                                std::vector<std::string_view>& args) {
+        size_t start = pos;
+        int64_t count;
+        size_t used = parse_header(buf, pos, '*', count);
+        if (used == 0 || used == kProtocolError) return used;
+        if (count < 1 || count > 1024 * 1024) return kProtocolError;
+        pos += used;
+
+        for (int64_t i = 0; i < count; ++i) {
+            int64_t len;
+            used = parse_header(buf, pos, '$', len);
+            if (used == 0 || used == kProtocolError) return used;
+            if (len < 0 || len > 512 * 1024 * 1024) return kProtocolError;
+            pos += used;
+            if (buf.size() - pos < static_cast<size_t>(len) + 2) return 0;
+            args.push_back(buf.substr(pos, static_cast<size_t>(len)));
+            pos += static_cast<size_t>(len) + 2;
+        }
+        return pos - start;
+    }
+
+    static size_t parse_header(std::string_view buf, size_t pos, char type,
+                               int64_t& value) {
+        if (pos >= buf.size()) return 0;
+        if (buf[pos] != type) return kProtocolError;
+        size_t end = buf.find("\r\n", pos);
+        if (end == std::string_view::npos) return 0;
+        if (!parse_int(buf.substr(pos + 1, end - pos - 1), value))
+            return kProtocolError;
+        return end + 2 - pos;
+    }
+
+    static bool parse_int(std::string_view text, int64_t& value) {
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        return result.ec == std::errc() && result.ptr == text.data() + text.size();
+    }
+
+    // NaN is rejected, as Redis does: it has no place in a sorted set.
+    static bool parse_double(std::string_view text, double& value) {
+        std::string copy(text);
+        char* end = nullptr;
+        value = std::strtod(copy.c_str(), &end);
+        return !copy.empty() && end == copy.c_str() + copy.size() && !std::isnan(value);
+    }
+
+    static bool equals(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if ((a[i] | 0x20) != (b[i] | 0x20)) return false;
+        }
+        return true;
+    }
+
+    static void reply_simple(std::string& out, std::string_view s) {
+        out += '+';
+        out += s;
+        out += "\r\n";
+    }
+
+    static void reply_error(std::string& out, std::string_view s) {
+        out += "-ERR ";
+        out += s;
+        out += "\r\n";
+    }
+
+    static void reply_int(std::string& out, int64_t v) {
+        out += ':';
+        out += std::to_string(v);
+        out += "\r\n";
+    }
+
+    static void reply_bulk(std::string& out, std::string_view s) {
+        out += '$';
+        out += std::to_string(s.size());
+        out += "\r\n";
+        out += s;
+        out += "\r\n";
+    }
+
+    static void reply_double(std::string& out, double v) {
+        char buf[32];
+        auto result = std::to_chars(buf, buf + sizeof(buf), v);
+        reply_bulk(out, std::string_view(buf, result.ptr - buf));
+    }
+
+    static void reply_null(std::string& out) { out += "$-1\r\n"; }
+
+    static void reply_array(std::string& out, size_t n) {
+        out += '*';
+        out += std::to_string(n);
+        out += "\r\n";
+    }
+
+    Shard& shard_for(std::string_view key) {
+        return *shards_[std::hash<std::string_view>{}(key) % shards_.size()];
+    }
+
+    void execute(const std::vector<std::string_view>& args, std::string& out) {
+        std::string_view cmd = args[0];
+        size_t argc = args.size();
+        if (equals(cmd, "PING")) {
+            argc > 1 ? reply_bulk(out, args[1]) : reply_simple(out, "PONG");
+        } else if (equals(cmd, "GET") && argc == 2) {
+            auto value = shard_for(args[1]).strings_.get(std::string(args[1]));
+            value ? reply_bulk(out, *value) : reply_null(out);
+        } else if (equals(cmd, "SET") && argc >= 3) {
+            shard_for(args[1]).strings_.put(std::string(args[1]), std::string(args[2]));
+            reply_simple(out, "OK");
+        } else if (equals(cmd, "DEL") && argc >= 2) {
+            int64_t removed = 0;
+            for (size_t i = 1; i < argc; ++i)
+                removed += shard_for(args[i]).strings_.remove(std::string(args[i]));
+            reply_int(out, removed);
+        } else if (equals(cmd, "EXISTS") && argc >= 2) {
+            int64_t found = 0;
+            for (size_t i = 1; i < argc; ++i)
+                found += shard_for(args[i]).strings_.contains(std::string(args[i]));
+            reply_int(out, found);
+        } else if (equals(cmd, "DBSIZE")) {
+            size_t total = 0;
+            for (auto& shard : shards_) total += shard->strings_.size();
+            reply_int(out, static_cast<int64_t>(total));
+        } else if (equals(cmd, "SCAN") && argc >= 2) {
+            scan(args, out);
+        } else if (equals(cmd, "ZADD") && argc >= 4 && argc % 2 == 0) {
+            zadd(args, out);
+        } else if (equals(cmd, "ZRANGE") && (argc == 4 || argc == 5)) {
+            zrange(args, out);
+        } else if (equals(cmd, "COMMAND") || equals(cmd, "CONFIG")) {
+            reply_array(out, 0);
+        } else {
+            reply_error(out, "unknown command or wrong number of arguments");
+        }
+    }
+
+    // A cursor names a ScanPosition, the shard and the last key returned,
+    // so the next call resumes right after that key whatever was removed
+    // meanwhile; every key present throughout a full scan is returned. Each
+    // reply gets a fresh cursor, so repeating a SCAN repeats its reply.
+    // Only the last kScanCursors cursors are kept; 0 starts and ends a scan.
+    void scan(const std::vector<std::string_view>& args, std::string& out) {
+        int64_t cursor;
+        int64_t count = 10;
+        if (!parse_int(args[1], cursor) || cursor < 0 ||
+            (args.size() == 4 && equals(args[2], "COUNT") &&
+             (!parse_int(args[3], count) || count < 1))) {
+            reply_error(out, "invalid cursor or count");
+            return;
+        }
+
+        size_t shard = 0;
+        std::optional<std::string> after;
+        if (cursor != 0) {
+            std::lock_guard<std::mutex> lock(scan_mutex_);
+            const auto& position = scan_positions_[static_cast<uint64_t>(cursor) % kScanCursors];
+            if (position.cursor_ != static_cast<uint64_t>(cursor)) {
+                reply_error(out, "invalid or expired cursor");
+                return;
+            }
+            shard = position.shard_;
+            after = position.last_key_;
+        }
+
+        std::vector<std::string> keys;
+        for (bool full = false; shard < shards_.size(); ++shard, after.reset()) {
+            shards_[shard]->strings_.scan(after ? *after : std::string(),
+                                          [&](const std::string& key, const std::string&) {
+                                              if (after && key == *after) return true;
+                                              keys.push_back(key);
+                                              full = keys.size() >= static_cast<size_t>(count);
+                                              return !full;
+                                          });
+            if (full) break;
+        }
+
+        uint64_t next = 0;
+        if (shard < shards_.size()) {
+            std::lock_guard<std::mutex> lock(scan_mutex_);
+            next = ++last_scan_cursor_;
+            scan_positions_[next % kScanCursors] = ScanPosition{next, shard, keys.back()};
+        }
+        reply_array(out, 2);
+        reply_bulk(out, std::to_string(next));
+        reply_array(out, keys.size());
+        for (const auto& key : keys) reply_bulk(out, key);
+    }
+
+    void zadd(const std::vector<std::string_view>& args, std::string& out) {
+        std::vector<double> scores;
+        for (size_t i = 2; i < args.size(); i += 2) {
+            double score;
+            if (!parse_double(args[i], score)) {
+                reply_error(out, "value is not a valid float");
+                return;
+            }
+            scores.push_back(score);
+        }
+
+        auto& set = shard_for(args[1]).sorted_set(args[1]);
+        std::lock_guard<std::mutex> lock(set.mutex_);
+        int64_t added = 0;
+        for (size_t i = 3; i < args.size(); i += 2) {
+            std::string member(args[i]);
+            double score = scores[(i - 3) / 2];
+            auto it = set.scores_.find(member);
+            if (it != set.scores_.end()) {
+                set.by_score_.remove({it->second, member});
+                it->second = score;
+            } else {
+                set.scores_.emplace(member, score);
+                ++added;
+            }
+            set.by_score_.put({score, std::move(member)}, true);
+        }
+        reply_int(out, added);
+    }
+
+    void zrange(const std::vector<std::string_view>& args, std::string& out) {
+        int64_t start, stop;
+        bool with_scores = args.size() == 5 && equals(args[4], "WITHSCORES");
+        if (!parse_int(args[2], start) || !parse_int(args[3], stop) ||
+            (args.size() == 5 && !with_scores)) {
+            reply_error(out, "syntax error");
+            return;
+        }
+
+        auto* set = shard_for(args[1]).find_sorted_set(args[1]);
+        if (!set) {
+            reply_array(out, 0);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(set->mutex_);
+        auto size = static_cast<int64_t>(set->by_score_.size());
+        if (start < 0) start = std::max<int64_t>(0, size + start);
+        if (stop < 0) stop += size;
+        if (stop >= size) stop = size - 1;
+        if (start > stop) {
+            reply_array(out, 0);
+            return;
+        }
+
+        reply_array(out, static_cast<size_t>(stop - start + 1) * (with_scores ? 2 : 1));
+        int64_t rank = 0;
+        Score lowest{-std::numeric_limits<double>::infinity(), ""};
+        set->by_score_.scan(lowest, [&](const Score& entry, bool) {
+            if (rank >= start) {
+                reply_bulk(out, entry.second);
+                if (with_scores) reply_double(out, entry.first);
+            }
+            return ++rank <= stop;
+        });
+    }
+
+    static constexpr size_t kScanCursors = 4096;
+
+    struct ScanPosition {
+        uint64_t cursor_{0};
+        size_t shard_{0};
+        std::string last_key_;
+    };
+
+    const uint16_t requested_port_;
+    const std::string bind_address_;
+    const size_t loop_count_;
+    uint16_t bound_port_{0};
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::vector<std::unique_ptr<EventLoop>> loops_;
+
+    std::mutex scan_mutex_;
+    std::vector<ScanPosition> scan_positions_ = std::vector<ScanPosition>(kScanCursors);
+    uint64_t last_scan_cursor_{0};
+};
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_RESP_SERVER_H
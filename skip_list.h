@@ -1,12 +1,27 @@
 #ifndef MOMU_SKIP_LIST_H
 #define MOMU_SKIP_LIST_H
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <random>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "key_prefix.h"
+#include "learned_index.h"
+
 namespace momu {
 namespace skip_list {
 
@@ -24,38 +39,62 @@ struct Node {
     std::vector<std::shared_ptr<Node<K, V>>> forward_;
 };
 
+enum class Mutation { kPut, kRemove };
+
+template <typename K, typename = void>
+struct IsHashable : std::false_type {};
+
+template <typename K>
+struct IsHashable<K, std::void_t<decltype(std::hash<K>{}(std::declval<const K&>()))>>
+    : std::true_type {};
+
+enum class VerifyResult { kOk, kCorrupt, kIncomplete };
+
 template <typename K, typename V>
 class SkipList {
    public:
+    // Listeners run under the list's lock, in mutation order, and must not
+    // call back into the list. The value is null for removals.
+    using Listener = std::function<void(Mutation, const K&, const V*)>;
+
     explicit SkipList(uint8_t max_level,
                       unsigned int seed = std::random_device{}())
         : max_level_(max_level),
           header_(std::make_unique<Node<K, V>>(K{}, V{}, max_level_)),
+          tails_(max_level_ + 1, header_.get()),
           gen_(seed),
           distribution_(0.5) {}
 
     SkipList(const SkipList&) = delete;
     SkipList& operator=(const SkipList&) = delete;
 
+    ~SkipList() { stop_tower_builder(); }
+
     void put(const K& key, const V& value) {
         std::lock_guard<std::mutex> lock(mutex_);
-        auto predecessors = find_predecessors(key);
-        if (auto* exist = get_node_at_level_zero(predecessors[0], key)) {
-            update_existing_node(exist, value);
+        if (is_past_tail(key)) {
+            insert_new_node(key, value, tails_);
         } else {
-            insert_new_node(key, value, predecessors);
+            auto predecessors = find_predecessors(key);
+            if (auto* exist = get_node_at_level_zero(predecessors[0], key)) {
+                update_existing_node(exist, value);
+            } else {
+                insert_new_node(key, value, predecessors);
+            }
         }
+        check_invariants();
+        notify(Mutation::kPut, key, &value);
     }
 
     std::optional<V> get(const K& key) {
         std::lock_guard<std::mutex> lock(mutex_);
-        if (auto* node = find_node(key)) return node->value_;
+        if (auto* node = lookup(key)) return node->value_;
         return std::nullopt;
     }
 
     bool contains(const K& key) {
         std::lock_guard<std::mutex> lock(mutex_);
-        return find_node(key) != nullptr;
+        return lookup(key) != nullptr;
     }
 
     bool remove(const K& key) {
@@ -66,27 +105,850 @@ class SkipList {
 
         delete_node(victim, predecessors);
         adjust_max_level();
+        check_invariants();
+        notify(Mutation::kRemove, key, nullptr);
         return true;
     }
 
-    size_t size() const { return element_count_; }
-    bool empty() const { return element_count_ == 0; }
+    // Drops every key less than key by relinking header_ past them, and
+    // returns how many were dropped. The detached nodes are freed after the
+    // lock is released, on a detached thread if reclaim_async is set.
+    size_t trim_before(const K& key, bool reclaim_async = false) {
+        NodePtr chain;
+        size_t removed = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto preds = find_predecessors(key);
+            if (preds[0] == header_.get()) return 0;
+            for (auto* cur = header_->forward_[0].get();;
+                 cur = cur->forward_[0].get()) {
+                ++removed;
+                notify(Mutation::kRemove, cur->key_, nullptr);
+                if (cur == preds[0]) break;
+            }
+            chain = detach_prefix(preds);
+            element_count_ -= removed;
+            adjust_max_level();
+            radix_trim(key);
+            refit_radix_fingers_if_drifted();
+            bias_trim(key);
+            check_invariants();
+        }
+        if (reclaim_async)
+            std::thread([chain = std::move(chain)]() mutable {
+                release_chain(std::move(chain));
+            }).detach();
+        else
+            release_chain(std::move(chain));
+        return removed;
+    }
 
-   private:
-    Node<K, V>* find_node(const K& key) { return traverse_to_level_zero(key); }
+    void merge(SkipList&& other) {
+        if (&other == this) return;
+        std::scoped_lock lock(mutex_, other.mutex_);
+        notify_merged(other);
+        other.bias_counts_.clear();
+        std::vector<Run> runs;
+        runs.push_back(merge_chains(detach_chain(), other.detach_chain()));
+        link_runs(runs);
+        check_invariants();
+        other.check_invariants();
+    }
+
+    void merge_parallel(SkipList&& other,
+                        size_t partitions = std::thread::hardware_concurrency()) {
+        if (&other == this) return;
+        std::scoped_lock lock(mutex_, other.mutex_);
+        notify_merged(other);
+        other.bias_counts_.clear();
+        auto pivots = choose_pivots(partitions);
+
+        PredVec own_cuts, other_cuts;
+        for (const auto& pivot : pivots) {
+            own_cuts.push_back(find_predecessors(pivot)[0]);
+            other_cuts.push_back(other.find_predecessors(pivot)[0]);
+        }
+        auto own_heads = split_chain(own_cuts);
+        auto other_heads = other.split_chain(other_cuts);
+
+        std::vector<Run> runs(own_heads.size());
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < runs.size(); ++i) {
+            workers.emplace_back([&, i] {
+                runs[i] = merge_chains(std::move(own_heads[i]),
+                                       std::move(other_heads[i]));
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        link_runs(runs);
+        check_invariants();
+        other.check_invariants();
+    }
+
+    // Visits every entry in key order while holding the lock.
+    template <typename Fn>
+    void for_each(Fn&& fn) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto* cur = header_->forward_[0].get(); cur;
+             cur = cur->forward_[0].get())
+            fn(cur->key_, cur->value_);
+    }
+
+    // Visits entries with keys not less than from, in key order, for as long
+    // as fn returns true. The lock is held throughout.
+    template <typename Fn>
+    void scan(const K& from, Fn&& fn) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Node<K, V>* cur = header_.get();
+        for (int i = current_max_level_; i >= 0; --i)
+            cur = move_forward_in_level(cur, i, from);
+        for (cur = cur->forward_[0].get(); cur; cur = cur->forward_[0].get()) {
+            if (!fn(cur->key_, cur->value_)) break;
+        }
+    }
+
+    size_t add_listener(Listener listener) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        listeners_.emplace_back(++last_listener_id_, std::move(listener));
+        return last_listener_id_;
+    }
+
+    bool remove_listener(size_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(listeners_.begin(), listeners_.end(),
+                               [id](const auto& entry) { return entry.first == id; });
+        if (it == listeners_.end()) return false;
+        listeners_.erase(it);
+        return true;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return element_count_;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    // Integral keys only. Fits a LearnedIndex over the nodes at level, and
+    // get and contains then start their descent at the node it predicts
+    // instead of at header_'s top level. Inserts only make the model lag,
+    // since the levels below stay authoritative; removals invalidate it.
+    // While lagging or invalid it is bypassed, and it is refitted once the
+    // lookups since then add up to its size, so refits are amortized.
+    void enable_learned_index(uint8_t level, size_t max_error = 16) {
+        static_assert(std::is_integral_v<K>, "the learned index needs integral keys");
+        std::lock_guard<std::mutex> lock(mutex_);
+        learned_level_ = std::min(level, max_level_);
+        learned_max_error_ = max_error;
+        fit_learned_index();
+    }
+
+    void disable_learned_index() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        learned_.reset();
+    }
+
+    // Integral and std::string keys only. Keeps a table of 2^bits entries
+    // (bits is clamped to [1, 24]), indexed by the top bits of key_prefix.
+    // Each holds the first node of its bucket and a finger: the last node
+    // at or before it whose tower reaches a level near log2 of the average
+    // bucket size. get and contains descend from the finger at that level,
+    // so a lookup costs about log2 of its bucket's size rather than of the
+    // list's, and never more than the plain search; a key below the first
+    // node, or in an empty bucket, is known to be missing without any
+    // search. Takes precedence over the learned index.
+    void enable_radix_head(uint8_t bits) {
+        static_assert(HasKeyPrefix<K>::value, "the radix head needs key_prefix keys");
+        std::lock_guard<std::mutex> lock(mutex_);
+        radix_bits_ = std::clamp<uint8_t>(bits, 1, 24);
+        rebuild_radix_table();
+    }
+
+    void disable_radix_head() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        radix_table_.clear();
+        radix_table_.shrink_to_fit();
+    }
+
+    // Biased mode for skewed lookups. One in sample_rate successful gets and
+    // contains counts a hit on the node found, and a node with h sampled
+    // hits is raised to level log2(4h), so hot keys sit in tall towers that
+    // searches reach in a few hops. Every sample also advances a sweep that
+    // halves the counts of a few nodes, and a promoted node whose count has
+    // decayed below its height goes back to a random one. The counts live in
+    // a side table holding only sampled nodes, so nodes carry nothing for
+    // this mode. Disabling drops the table and keeps the heights as they are.
+    void enable_biased(uint32_t sample_rate = 16) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bias_sample_rate_ = std::max<uint32_t>(sample_rate, 1);
+    }
+
+    void disable_biased() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bias_sample_rate_ = 0;
+        std::unordered_map<Node<K, V>*, BiasCount>().swap(bias_counts_);
+    }
+
+    // Hashable keys only. A direct-mapped cache of entries (rounded up to a
+    // power of two) from key hash to the node a get or contains found, so a
+    // repeated lookup skips the search. Entries are stamped with
+    // removal_epoch_ and ignored once any node leaves the list, so they are
+    // never stale; misses are not cached.
+    void enable_lookup_cache(size_t entries) {
+        static_assert(IsHashable<K>::value, "the lookup cache needs std::hash keys");
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t size = 1;
+        while (size < entries) size <<= 1;
+        lookup_cache_.assign(size, CacheEntry{});
+    }
+
+    void disable_lookup_cache() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lookup_cache_.clear();
+        lookup_cache_.shrink_to_fit();
+    }
+
+    // Lazy towers. put links a new node at level 0 only and queues its
+    // random height; a background thread wakes every interval and builds
+    // the queued towers in short batches under the lock, so a put holds the
+    // lock for a level-0 splice. Lookups stay correct meanwhile, only
+    // slower until the towers catch up. Removes stay eager. Disabling stops
+    // the thread and builds whatever is still queued.
+    void enable_lazy_towers(std::chrono::microseconds interval = std::chrono::milliseconds(1)) {
+        std::lock_guard<std::mutex> control(tower_control_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (lazy_towers_) return;
+        lazy_towers_ = true;
+        tower_builder_ = std::thread([this, interval] { build_towers_in_background(interval); });
+    }
 
+    void disable_lazy_towers() {
+        stop_tower_builder();
+        std::lock_guard<std::mutex> lock(mutex_);
+        build_pending_towers(std::numeric_limits<size_t>::max());
+    }
+
+    // Heap bytes held by the list's own structure: each node's shared
+    // allocation (node plus control block) and its forward_ array, the
+    // header and tails_, and the capacity of every optional structure that
+    // is enabled or still allocated: the radix table, the lookup cache, the
+    // learned index, the biased-mode counts, the queued towers and the
+    // listeners. Hash-map and deque storage is estimated from its element
+    // and bucket counts. Memory owned by keys and values themselves, and
+    // allocator overhead, are not included. Walks the list under the lock.
+    size_t memory_usage() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t bytes = sizeof(Node<K, V>) + forward_bytes(*header_) +
+                       tails_.capacity() * sizeof(Node<K, V>*);
+        for (auto* cur = header_->forward_[0].get(); cur;
+             cur = cur->forward_[0].get())
+            bytes += shared_node_bytes() + forward_bytes(*cur);
+        return bytes + optional_bytes();
+    }
+
+    // Progress of an incremental verify. It starts over whenever the list's
+    // structure changed since the previous step.
+    class VerifyState {
+       private:
+        friend class SkipList;
+
+        bool started_{false};
+        uint64_t version_{0};
+        int level_{0};
+        Node<K, V>* cur_{nullptr};
+        Node<K, V>* below_{nullptr};
+        size_t count_{0};
+    };
+
+    // Checks that every level is sorted and a sublist of the one below, that
+    // the level-0 length matches size(), that the tails are the last nodes
+    // and that current_max_level_ is tight. Each call follows at most about
+    // budget links, so a full pass can be spread over many short lock holds;
+    // kIncomplete means call again with the same state.
+    VerifyResult verify(VerifyState& state, size_t budget) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return verify_locked(state, budget);
+    }
+
+    bool verify() {
+        VerifyState state;
+        return verify(state, std::numeric_limits<size_t>::max()) == VerifyResult::kOk;
+    }
+
+    // The set operations take values from lhs and put the results into out,
+    // which keeps its other entries. The results are collected with only lhs
+    // and rhs locked and written afterwards, so out may be lhs or rhs:
+    // set_union(a, b, a) adds b to a.
+    friend void set_intersection(SkipList& lhs, SkipList& rhs, SkipList& out) {
+        Entries result;
+        {
+            auto locks = lock_both(lhs, rhs);
+            bool lhs_smaller = lhs.element_count_ <= rhs.element_count_;
+            SkipList& small = lhs_smaller ? lhs : rhs;
+            SkipList& large = lhs_smaller ? rhs : lhs;
+
+            PredVec finger(large.max_level_ + 1, large.header_.get());
+            for (auto* cur = small.header_->forward_[0].get(); cur;
+                 cur = cur->forward_[0].get()) {
+                auto* hit = large.seek(finger, cur->key_);
+                if (hit && hit->key_ == cur->key_)
+                    result.emplace_back(cur->key_, lhs_smaller ? cur->value_ : hit->value_);
+            }
+        }
+        out.put_all(result);
+    }
+
+    friend void set_union(SkipList& lhs, SkipList& rhs, SkipList& out) {
+        Entries result;
+        {
+            auto locks = lock_both(lhs, rhs);
+            auto* a = lhs.header_->forward_[0].get();
+            auto* b = rhs.header_->forward_[0].get();
+            while (a || b) {
+                if (!b || (a && !(b->key_ < a->key_))) {
+                    result.emplace_back(a->key_, a->value_);
+                    if (b && !(a->key_ < b->key_)) b = b->forward_[0].get();
+                    a = a->forward_[0].get();
+                } else {
+                    result.emplace_back(b->key_, b->value_);
+                    b = b->forward_[0].get();
+                }
+            }
+        }
+        out.put_all(result);
+    }
+
+    friend void set_difference(SkipList& lhs, SkipList& rhs, SkipList& out) {
+        Entries result;
+        {
+            auto locks = lock_both(lhs, rhs);
+            PredVec finger(rhs.max_level_ + 1, rhs.header_.get());
+            for (auto* cur = lhs.header_->forward_[0].get(); cur;
+                 cur = cur->forward_[0].get()) {
+                auto* hit = rhs.seek(finger, cur->key_);
+                if (!hit || !(hit->key_ == cur->key_)) result.emplace_back(cur->key_, cur->value_);
+            }
+        }
+        out.put_all(result);
+    }
+
+   private:
     using PredVec = std::vector<Node<K, V>*>;
+    using Entries = std::vector<std::pair<K, V>>;
+
+    VerifyResult verify_locked(VerifyState& state, size_t budget) {
+        if (!state.started_ || state.version_ != version_) restart_verify(state);
+        while (budget > 0) {
+            if (state.level_ > current_max_level_) {
+                state.started_ = false;
+                return verify_empty_levels() ? VerifyResult::kOk : VerifyResult::kCorrupt;
+            }
+            auto* next = state.cur_->forward_[state.level_].get();
+            bool ok = next ? verify_link(state, next, budget)
+                           : verify_level_end(state);
+            if (!ok) {
+                state.started_ = false;
+                return VerifyResult::kCorrupt;
+            }
+        }
+        return VerifyResult::kIncomplete;
+    }
+
+    // Building with MOMU_SKIP_LIST_CHECK_INVARIANTS runs a full verify after
+    // every mutation and aborts on a violation. That makes mutations O(n),
+    // so it is meant for debug and fuzzing builds.
+    void check_invariants() {
+#ifdef MOMU_SKIP_LIST_CHECK_INVARIANTS
+        VerifyState state;
+        if (verify_locked(state, std::numeric_limits<size_t>::max()) != VerifyResult::kOk)
+            std::abort();
+#endif
+    }
+
+    void restart_verify(VerifyState& state) {
+        state = VerifyState();
+        state.started_ = true;
+        state.version_ = version_;
+        state.cur_ = state.below_ = header_.get();
+    }
+
+    bool verify_link(VerifyState& state, Node<K, V>* next, size_t& budget) {
+        int lvl = state.level_;
+        --budget;
+        if (next->forward_.size() <= static_cast<size_t>(lvl)) return false;
+        if (state.cur_ != header_.get() && !(state.cur_->key_ < next->key_))
+            return false;
+        if (lvl == 0) ++state.count_;
+        while (lvl > 0 && state.below_ != next) {
+            state.below_ = state.below_->forward_[lvl - 1].get();
+            if (!state.below_) return false;
+            if (budget > 0) --budget;
+        }
+        state.cur_ = next;
+        return true;
+    }
+
+    bool verify_level_end(VerifyState& state) {
+        int lvl = state.level_;
+        if (tails_[lvl] != state.cur_) return false;
+        if (lvl == 0 && state.count_ != element_count_) return false;
+        if (lvl > 0 && state.cur_ == header_.get()) return false;
+        ++state.level_;
+        state.cur_ = state.below_ = header_.get();
+        return true;
+    }
+
+    bool verify_empty_levels() const {
+        for (size_t i = current_max_level_ + 1; i < tails_.size(); ++i) {
+            if (header_->forward_[i] || tails_[i] != header_.get()) return false;
+        }
+        return true;
+    }
+
+    // Records what allocate_shared asks for. It is stateless, so the control
+    // block is laid out exactly as with the std::allocator of make_shared.
+    template <typename T>
+    struct SizeProbe {
+        using value_type = T;
+
+        SizeProbe() = default;
+        template <typename U>
+        SizeProbe(const SizeProbe<U>&) {}
+
+        T* allocate(size_t n) {
+            probed_bytes() = n * sizeof(T);
+            return std::allocator<T>().allocate(n);
+        }
+        void deallocate(T* p, size_t n) { std::allocator<T>().deallocate(p, n); }
+
+        template <typename U>
+        bool operator==(const SizeProbe<U>&) const { return true; }
+        template <typename U>
+        bool operator!=(const SizeProbe<U>&) const { return false; }
+    };
+
+    static size_t& probed_bytes() {
+        static size_t bytes = 0;
+        return bytes;
+    }
+
+    // The size of one make_shared<Node> allocation, node plus control
+    // block, as this standard library lays it out.
+    static size_t shared_node_bytes() {
+        static const size_t bytes = [] {
+            std::allocate_shared<Node<K, V>>(SizeProbe<Node<K, V>>());
+            return probed_bytes();
+        }();
+        return bytes;
+    }
+
+    size_t optional_bytes() const {
+        using BiasEntry = typename decltype(bias_counts_)::value_type;
+        using PendingTower = typename decltype(pending_towers_)::value_type;
+        size_t bytes = radix_table_.capacity() * sizeof(RadixEntry) +
+                       lookup_cache_.capacity() * sizeof(CacheEntry) +
+                       listeners_.capacity() * sizeof(listeners_[0]);
+        if (learned_) bytes += sizeof(*learned_) + learned_->memory_usage();
+        // One allocation per entry holding the pair and a next pointer.
+        bytes += bias_counts_.size() * (sizeof(BiasEntry) + sizeof(void*)) +
+                 bias_counts_.bucket_count() * sizeof(void*);
+        bytes += pending_towers_.size() * sizeof(PendingTower);
+        return bytes;
+    }
+
+    static size_t forward_bytes(const Node<K, V>& node) {
+        return node.forward_.capacity() * sizeof(std::shared_ptr<Node<K, V>>);
+    }
+
+    Node<K, V>* lookup(const K& key) {
+        auto* node = find_cached_node(key);
+        if (node && bias_sample_rate_ && ++bias_tick_ >= bias_sample_rate_) {
+            bias_tick_ = 0;
+            record_hit(node);
+        }
+        return node;
+    }
+
+    struct CacheEntry {
+        Node<K, V>* node_{nullptr};
+        uint64_t epoch_{0};
+    };
+
+    Node<K, V>* find_cached_node(const K& key) {
+        if constexpr (IsHashable<K>::value) {
+            if (!lookup_cache_.empty()) {
+                auto& entry = lookup_cache_[std::hash<K>{}(key) & (lookup_cache_.size() - 1)];
+                if (entry.node_ && entry.epoch_ == removal_epoch_ && entry.node_->key_ == key)
+                    return entry.node_;
+                auto* node = find_node(key);
+                if (node) entry = CacheEntry{node, removal_epoch_};
+                return node;
+            }
+        }
+        return find_node(key);
+    }
+
+    static constexpr size_t kDecayBatch = 4;
+
+    // The decay sweep halves a count about every n / kDecayBatch samples, so
+    // a count estimates a quarter of n times the key's share of lookups, and
+    // log2 of that product is the height a biased skip list gives the key.
+    uint8_t earned_level(uint32_t hits) const {
+        if (!hits) return 0;
+        uint8_t level = 2;
+        while (hits >>= 1) ++level;
+        return std::min(level, max_level_);
+    }
+
+    void record_hit(Node<K, V>* node) {
+        auto& count = bias_counts_[node];
+        if (count.hits_ < std::numeric_limits<uint32_t>::max()) ++count.hits_;
+        uint8_t earned = earned_level(count.hits_);
+        if (earned + size_t{1} > node->forward_.size()) {
+            retower(node, earned, find_predecessors(node->key_));
+            count.promoted_ = true;
+        }
+        decay_step();
+    }
+
+    // Halves the hit counts of the next few nodes, wrapping around at the
+    // end, and forgets nodes left with no hits and no promotion. The cursor
+    // stays valid until a node leaves the list.
+    void decay_step() {
+        if (!decay_cursor_ || decay_epoch_ != removal_epoch_) decay_cursor_ = header_.get();
+        for (size_t i = 0; i < kDecayBatch; ++i) {
+            auto* next = decay_cursor_->forward_[0].get();
+            if (!next) {
+                decay_cursor_ = header_.get();
+                break;
+            }
+            decay_cursor_ = next;
+            auto it = bias_counts_.find(next);
+            if (it == bias_counts_.end()) continue;
+            auto& count = it->second;
+            count.hits_ >>= 1;
+            uint8_t earned = earned_level(count.hits_);
+            if (count.promoted_ && earned + size_t{1} < next->forward_.size()) {
+                uint8_t lvl = std::max(earned, generate_random_level());
+                if (lvl + size_t{1} < next->forward_.size())
+                    retower(next, lvl, find_predecessors(next->key_));
+                count.promoted_ = false;
+            }
+            if (!count.hits_ && !count.promoted_) bias_counts_.erase(it);
+        }
+        decay_epoch_ = removal_epoch_;
+    }
+
+    // After trim_before(key), while the detached nodes are still alive.
+    void bias_trim(const K& key) {
+        for (auto it = bias_counts_.begin(); it != bias_counts_.end();) {
+            if (it->first->key_ < key)
+                it = bias_counts_.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    // Relinks node, whose predecessors are preds, with its top level at
+    // lvl. Lowering a tower counts as a removal for node pointers held
+    // outside the levels.
+    void retower(Node<K, V>* node, uint8_t lvl, PredVec preds) {
+        NodePtr self = preds[0]->forward_[0];
+        size_t old_top = node->forward_.size() - 1;
+        bool was_tall = radix_tall(node);
+        if (lvl > old_top) {
+            adjust_max_level_for_insertion(lvl, preds);
+            node->forward_.resize(lvl + 1);
+            for (size_t i = old_top + 1; i <= lvl; ++i) {
+                node->forward_[i] = std::move(preds[i]->forward_[i]);
+                preds[i]->forward_[i] = self;
+                if (!node->forward_[i]) tails_[i] = node;
+            }
+        } else {
+            for (size_t i = lvl + 1; i <= old_top; ++i) {
+                preds[i]->forward_[i] = std::move(node->forward_[i]);
+                if (tails_[i] == node) tails_[i] = preds[i];
+            }
+            node->forward_.resize(lvl + 1);
+            adjust_max_level();
+            ++removal_epoch_;
+        }
+        if (radix_tall(node) != was_tall) radix_retower(node, preds);
+        ++version_;
+    }
+
+    static constexpr size_t kTowerBatch = 64;
+
+    void build_towers_in_background(std::chrono::microseconds interval) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (lazy_towers_) {
+            if (pending_towers_.empty()) {
+                tower_wake_.wait_for(lock, interval);
+                continue;
+            }
+            build_pending_towers(kTowerBatch);
+            lock.unlock();
+            std::this_thread::yield();
+            lock.lock();
+        }
+    }
+
+    // Queued keys that were removed meanwhile are skipped.
+    void build_pending_towers(size_t limit) {
+        for (; limit > 0 && !pending_towers_.empty(); --limit) {
+            auto [key, lvl] = std::move(pending_towers_.front());
+            pending_towers_.pop_front();
+            auto preds = find_predecessors(key);
+            auto* node = get_node_at_level_zero(preds[0], key);
+            if (node && lvl + size_t{1} > node->forward_.size())
+                retower(node, lvl, std::move(preds));
+        }
+        check_invariants();
+    }
+
+    void stop_tower_builder() {
+        std::lock_guard<std::mutex> control(tower_control_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            lazy_towers_ = false;
+        }
+        tower_wake_.notify_one();
+        if (tower_builder_.joinable()) tower_builder_.join();
+    }
+
+    Node<K, V>* find_node(const K& key) {
+        if constexpr (HasKeyPrefix<K>::value) {
+            if (!radix_table_.empty()) {
+                const auto& entry = radix_table_[radix_bucket(key)];
+                if (!entry.first_ || key < entry.first_->key_) return nullptr;
+                if (!(entry.first_->key_ < key)) return entry.first_;
+                int top = entry.finger_ == header_.get() ? current_max_level_ : radix_level_;
+                return descend(entry.finger_, top, key);
+            }
+        }
+        return traverse_to_level_zero(key);
+    }
+
+    size_t radix_bucket(const K& key) const { return key_prefix(key) >> (64 - radix_bits_); }
+
+    // Tall nodes are the ones reaching radix_level_, where fingers sit.
+    bool radix_tall(const Node<K, V>* node) const {
+        return node->forward_.size() > radix_level_;
+    }
+
+    // The last tall node before a key whose predecessors are preds.
+    Node<K, V>* radix_pred(const PredVec& preds) const {
+        auto* pred = preds[radix_level_];
+        return pred ? pred : header_.get();
+    }
+
+    void rebuild_radix_table() {
+        radix_table_.assign(size_t{1} << radix_bits_, RadixEntry{});
+        radix_used_ = 0;
+        for (auto* cur = header_->forward_[0].get(); cur; cur = cur->forward_[0].get()) {
+            auto& entry = radix_table_[radix_bucket(cur->key_)];
+            if (!entry.first_) {
+                entry.first_ = cur;
+                ++radix_used_;
+            }
+        }
+        fit_radix_fingers();
+    }
+
+    // Puts radix_level_ near log2 of the average bucket size, so a search
+    // from a finger crosses a bucket in a few hops at that level, and
+    // points every bucket's finger at the last tall node not after its
+    // first node. Refitted whenever the size has halved or doubled since.
+    void fit_radix_fingers() {
+        size_t per_bucket = radix_used_ ? element_count_ / radix_used_ : 0;
+        radix_level_ = 0;
+        while (per_bucket >>= 1) ++radix_level_;
+        radix_level_ = std::min(radix_level_, max_level_);
+        radix_fitted_count_ = element_count_;
+        auto* finger = header_.get();
+        for (auto* cur = header_->forward_[0].get(); cur; cur = cur->forward_[0].get()) {
+            if (radix_tall(cur)) finger = cur;
+            auto& entry = radix_table_[radix_bucket(cur->key_)];
+            if (entry.first_ == cur) entry.finger_ = finger;
+        }
+    }
+
+    void refit_radix_fingers_if_drifted() {
+        if constexpr (HasKeyPrefix<K>::value) {
+            if (radix_table_.empty()) return;
+            if (element_count_ > radix_fitted_count_ * 2 + 64 ||
+                element_count_ * 2 + 64 < radix_fitted_count_)
+                fit_radix_fingers();
+        }
+    }
+
+    // Bucket heads after node, up to the next tall node, have their finger
+    // at node or before it; points them at finger instead.
+    void radix_repoint(Node<K, V>* node, Node<K, V>* finger) {
+        for (auto* cur = node->forward_[0].get(); cur && !radix_tall(cur);
+             cur = cur->forward_[0].get()) {
+            auto& entry = radix_table_[radix_bucket(cur->key_)];
+            if (entry.first_ == cur) entry.finger_ = finger;
+        }
+    }
+
+    // After node is linked with predecessors preds.
+    void radix_insert(Node<K, V>* node, const PredVec& preds) {
+        if constexpr (HasKeyPrefix<K>::value) {
+            if (radix_table_.empty()) return;
+            bool tall = radix_tall(node);
+            auto& entry = radix_table_[radix_bucket(node->key_)];
+            if (!entry.first_ || node->key_ < entry.first_->key_) {
+                if (!entry.first_) ++radix_used_;
+                entry.first_ = node;
+                entry.finger_ = tall ? node : radix_pred(preds);
+            }
+            if (tall) radix_repoint(node, node);
+        }
+    }
+
+    // Before node is unlinked; preds are its predecessors.
+    void radix_remove(Node<K, V>* node, const PredVec& preds) {
+        if constexpr (HasKeyPrefix<K>::value) {
+            if (radix_table_.empty()) return;
+            size_t bucket = radix_bucket(node->key_);
+            auto& entry = radix_table_[bucket];
+            if (entry.first_ == node) {
+                auto* next = node->forward_[0].get();
+                if (next && radix_bucket(next->key_) == bucket) {
+                    entry.first_ = next;
+                    if (radix_tall(next)) entry.finger_ = next;
+                } else {
+                    entry = RadixEntry{};
+                    --radix_used_;
+                }
+            }
+            if (radix_tall(node)) {
+                auto* finger = radix_pred(preds);
+                if (entry.finger_ == node) entry.finger_ = finger;
+                radix_repoint(node, finger);
+            }
+        }
+    }
+
+    // After retower moved node's top level across radix_level_.
+    void radix_retower(Node<K, V>* node, const PredVec& preds) {
+        if constexpr (HasKeyPrefix<K>::value) {
+            if (radix_table_.empty()) return;
+            auto* finger = radix_tall(node) ? node : radix_pred(preds);
+            auto& entry = radix_table_[radix_bucket(node->key_)];
+            if (entry.first_ == node) entry.finger_ = finger;
+            radix_repoint(node, finger);
+        }
+    }
+
+    // After trim_before(key): every entry below key is gone, the new first
+    // node may now open key's bucket, and the heads up to the first tall
+    // node left have lost their finger.
+    void radix_trim(const K& key) {
+        if constexpr (HasKeyPrefix<K>::value) {
+            if (radix_table_.empty()) return;
+            size_t last = radix_bucket(key);
+            for (size_t bucket = 0; bucket <= last; ++bucket) {
+                auto& entry = radix_table_[bucket];
+                if (entry.first_ && entry.first_->key_ < key) {
+                    entry = RadixEntry{};
+                    --radix_used_;
+                }
+            }
+            auto* first = header_->forward_[0].get();
+            if (!first) return;
+            auto& entry = radix_table_[radix_bucket(first->key_)];
+            if (!entry.first_) {
+                entry.first_ = first;
+                ++radix_used_;
+            }
+            if (entry.first_ == first) entry.finger_ = radix_tall(first) ? first : header_.get();
+            if (!radix_tall(first)) radix_repoint(first, header_.get());
+        }
+    }
+
+    void radix_relink() {
+        if constexpr (HasKeyPrefix<K>::value) {
+            if (!radix_table_.empty()) rebuild_radix_table();
+        }
+    }
+
     PredVec find_predecessors(const K& key) {
         PredVec preds(max_level_ + 1, nullptr);
         traverse_and_collect_predecessors(key, preds);
         return preds;
     }
 
+    // Keys beyond the current maximum are linked straight after the per-level
+    // tails, skipping the search from header_.
+    bool is_past_tail(const K& key) const {
+        return tails_[0] == header_.get() || tails_[0]->key_ < key;
+    }
+
     Node<K, V>* traverse_to_level_zero(const K& key) {
-        Node<K, V>* cur = header_.get();
-        for (int i = current_max_level_; i >= 0; --i)
+        auto [cur, top] = search_start(key);
+        return descend(cur, top, key);
+    }
+
+    // cur's key must be less than key, or cur be header_. Stops at the
+    // first level where key is met, so tall towers end searches early.
+    Node<K, V>* descend(Node<K, V>* cur, int top, const K& key) {
+        for (int i = top; i >= 0; --i) {
             cur = move_forward_in_level(cur, i, key);
-        return get_target_node(cur, key);
+            auto* next = cur->forward_[i].get();
+            if (next && !(key < next->key_)) return next;
+        }
+        return nullptr;
+    }
+
+    // cur's key must be less than key. Walks forward while the next node is
+    // still before key, moving up to each taller node's top level, and then
+    // descends from the level reached. A node at level i is followed by a
+    // taller one after about two hops, so the climb stops near log2 of the
+    // distance to key.
+    Node<K, V>* finger_search(Node<K, V>* cur, const K& key) {
+        int top = static_cast<int>(cur->forward_.size()) - 1;
+        for (auto* next = cur->forward_[top].get(); next && next->key_ < key;
+             next = cur->forward_[top].get()) {
+            cur = next;
+            top = static_cast<int>(cur->forward_.size()) - 1;
+        }
+        return descend(cur, top, key);
+    }
+
+    // A node whose key is less than key and the level to descend from.
+    std::pair<Node<K, V>*, int> search_start(const K& key) {
+        if constexpr (std::is_integral_v<K>) {
+            if (learned_ && learned_index_usable()) {
+                auto* node = learned_->predecessor(key);
+                return {node ? node : header_.get(), learned_level_};
+            }
+        }
+        return {header_.get(), current_max_level_};
+    }
+
+    bool learned_index_usable() {
+        bool fresh = learned_epoch_ == removal_epoch_ &&
+                     (version_ - learned_version_) * 2 <= learned_elements_ + 128;
+        if (!fresh) {
+            if (++learned_debt_ < std::max<size_t>(learned_->node_count(), 64)) return false;
+            fit_learned_index();
+        }
+        return true;
+    }
+
+    void fit_learned_index() {
+        std::vector<Node<K, V>*> nodes;
+        for (auto* cur = header_->forward_[learned_level_].get(); cur;
+             cur = cur->forward_[learned_level_].get())
+            nodes.push_back(cur);
+        learned_ = std::make_unique<LearnedIndex<Node<K, V>>>(std::move(nodes),
+                                                               learned_max_error_);
+        learned_epoch_ = removal_epoch_;
+        learned_version_ = version_;
+        learned_elements_ = element_count_;
+        learned_debt_ = 0;
     }
 
     void traverse_and_collect_predecessors(const K& key, PredVec& preds) {
@@ -119,6 +981,10 @@ class SkipList {
 
     void insert_new_node(const K& key, const V& value, const PredVec& preds) {
         uint8_t lvl = generate_random_level();
+        if (lazy_towers_ && lvl > 0) {
+            pending_towers_.emplace_back(key, lvl);
+            lvl = 0;
+        }
         PredVec mutable_preds = preds;
         adjust_max_level_for_insertion(lvl, mutable_preds);
 
@@ -126,16 +992,26 @@ class SkipList {
         for (uint8_t i = 0; i <= lvl; ++i) {
             new_node->forward_[i] = mutable_preds[i]->forward_[i];
             mutable_preds[i]->forward_[i] = new_node;
+            if (!new_node->forward_[i]) tails_[i] = new_node.get();
         }
         ++element_count_;
+        ++version_;
+        radix_insert(new_node.get(), mutable_preds);
+        refit_radix_fingers_if_drifted();
     }
 
     void delete_node(Node<K, V>* node, const PredVec& preds) {
+        radix_remove(node, preds);
+        if (!bias_counts_.empty()) bias_counts_.erase(node);
         for (uint8_t i = 0; i <= current_max_level_; ++i) {
             if (preds[i]->forward_[i].get() == node)
                 preds[i]->forward_[i] = node->forward_[i];
+            if (tails_[i] == node) tails_[i] = preds[i];
         }
         --element_count_;
+        ++version_;
+        ++removal_epoch_;
+        refit_radix_fingers_if_drifted();
     }
 
     void adjust_max_level() {
@@ -161,10 +1037,245 @@ class SkipList {
         }
     }
 
+    using NodePtr = std::shared_ptr<Node<K, V>>;
+
+    struct Run {
+        std::vector<NodePtr> heads_;
+        PredVec tails_;
+        size_t count_{0};
+    };
+
+    NodePtr detach_chain() {
+        NodePtr chain = std::move(header_->forward_[0]);
+        for (auto& next : header_->forward_) next.reset();
+        std::fill(tails_.begin(), tails_.end(), header_.get());
+        std::fill(radix_table_.begin(), radix_table_.end(), RadixEntry{});
+        radix_used_ = 0;
+        current_max_level_ = 0;
+        element_count_ = 0;
+        ++version_;
+        ++removal_epoch_;
+        return chain;
+    }
+
+    void notify(Mutation op, const K& key, const V* value) {
+        for (auto& entry : listeners_) entry.second(op, key, value);
+    }
+
+    // Every entry of other moves here: a put for this list's listeners and
+    // a removal for other's, which would otherwise see other emptied
+    // without a word.
+    void notify_merged(SkipList& other) {
+        if (listeners_.empty() && other.listeners_.empty()) return;
+        for (auto* cur = other.header_->forward_[0].get(); cur;
+             cur = cur->forward_[0].get()) {
+            notify(Mutation::kPut, cur->key_, &cur->value_);
+            other.notify(Mutation::kRemove, cur->key_, nullptr);
+        }
+    }
+
+    NodePtr detach_prefix(const PredVec& preds) {
+        for (int i = current_max_level_; i > 0; --i) {
+            if (preds[i] != header_.get())
+                header_->forward_[i] = preds[i]->forward_[i];
+        }
+        NodePtr chain = std::move(header_->forward_[0]);
+        header_->forward_[0] = std::move(preds[0]->forward_[0]);
+        for (size_t i = 0; i < tails_.size(); ++i) {
+            if (!header_->forward_[i]) tails_[i] = header_.get();
+        }
+        ++version_;
+        ++removal_epoch_;
+        return chain;
+    }
+
+    // Frees a detached chain front to back, so long chains do not recurse
+    // through nested shared_ptr destructors.
+    static void release_chain(NodePtr chain) {
+        while (chain) chain = std::move(chain->forward_[0]);
+    }
+
+    std::vector<K> choose_pivots(size_t partitions) {
+        std::vector<K> pivots;
+        if (partitions < 2) return pivots;
+        std::vector<Node<K, V>*> candidates;
+        for (int i = current_max_level_; i >= 0; --i) {
+            candidates.clear();
+            for (auto* cur = header_->forward_[i].get(); cur;
+                 cur = cur->forward_[i].get())
+                candidates.push_back(cur);
+            if (candidates.size() >= partitions - 1) break;
+        }
+        size_t count = std::min(partitions - 1, candidates.size());
+        for (size_t i = 1; i <= count; ++i)
+            pivots.push_back(candidates[i * candidates.size() / (count + 1)]->key_);
+        return pivots;
+    }
+
+    // Cuts are made back to front so that repeated cuts at the same
+    // predecessor leave the earlier segments empty.
+    std::vector<NodePtr> split_chain(const PredVec& cuts) {
+        std::vector<NodePtr> heads(cuts.size() + 1);
+        for (size_t i = cuts.size(); i > 0; --i)
+            heads[i] = std::move(cuts[i - 1]->forward_[0]);
+        heads[0] = detach_chain();
+        return heads;
+    }
+
+    Run merge_chains(NodePtr a, NodePtr b) {
+        Node<K, V> head;
+        head.forward_.resize(max_level_ + 1);
+        PredVec tails(max_level_ + 1, &head);
+        Run run;
+
+        while (a || b) {
+            NodePtr node;
+            if (!b || (a && a->key_ < b->key_)) {
+                node = std::move(a);
+                a = node->forward_[0];
+            } else if (!a || b->key_ < a->key_) {
+                node = std::move(b);
+                b = node->forward_[0];
+            } else {
+                node = std::move(a);
+                a = node->forward_[0];
+                node->value_ = std::move(b->value_);
+                b = b->forward_[0];
+            }
+            append_to_run(node, tails);
+            ++run.count_;
+        }
+
+        run.heads_ = std::move(head.forward_);
+        run.tails_ = std::move(tails);
+        return run;
+    }
+
+    void append_to_run(const NodePtr& node, PredVec& tails) {
+        if (node->forward_.size() > static_cast<size_t>(max_level_) + 1)
+            node->forward_.resize(max_level_ + 1);
+        for (size_t i = 0; i < node->forward_.size(); ++i) {
+            tails[i]->forward_[i] = node;
+            tails[i] = node.get();
+        }
+    }
+
+    void link_runs(std::vector<Run>& runs) {
+        PredVec tails(max_level_ + 1, header_.get());
+        for (auto& run : runs) {
+            for (size_t i = 0; i < tails.size(); ++i) {
+                if (!run.heads_[i]) continue;
+                tails[i]->forward_[i] = std::move(run.heads_[i]);
+                tails[i] = run.tails_[i];
+            }
+            element_count_ += run.count_;
+        }
+        for (size_t i = 0; i < tails.size(); ++i) {
+            tails[i]->forward_[i].reset();
+            if (tails[i] != header_.get()) current_max_level_ = i;
+        }
+        tails_ = std::move(tails);
+        ++version_;
+        radix_relink();
+    }
+
+    void put_all(const Entries& entries) {
+        for (const auto& [key, value] : entries) put(key, value);
+    }
+
+    static std::pair<std::unique_lock<std::mutex>, std::unique_lock<std::mutex>>
+    lock_both(SkipList& a, SkipList& b) {
+        std::unique_lock<std::mutex> first(a.mutex_, std::defer_lock);
+        std::unique_lock<std::mutex> second(b.mutex_, std::defer_lock);
+        if (&a == &b)
+            first.lock();
+        else
+            std::lock(first, second);
+        return {std::move(first), std::move(second)};
+    }
+
+    // Finger search for the first node not less than key. The finger holds
+    // the predecessors of the previous (smaller) key, so the search only
+    // climbs as high as the distance travelled requires.
+    Node<K, V>* seek(PredVec& finger, const K& key) {
+        int top = 0;
+        while (top < current_max_level_ && has_smaller_next(finger[top], top, key))
+            ++top;
+        Node<K, V>* cur = finger[top];
+        for (int i = top; i >= 0; --i) {
+            if (is_before(cur, finger[i])) cur = finger[i];
+            cur = move_forward_in_level(cur, i, key);
+            finger[i] = cur;
+        }
+        return cur->forward_[0].get();
+    }
+
+    bool has_smaller_next(Node<K, V>* node, int lvl, const K& key) const {
+        return node->forward_[lvl] && node->forward_[lvl]->key_ < key;
+    }
+
+    bool is_before(Node<K, V>* a, Node<K, V>* b) const {
+        if (a == b || b == header_.get()) return false;
+        return a == header_.get() || a->key_ < b->key_;
+    }
+
     uint8_t max_level_;
     uint8_t current_max_level_{0};
     std::unique_ptr<Node<K, V>> header_;
+    PredVec tails_;
     size_t element_count_{0};
+    // Bumped on every structural change; restarts incremental verifies.
+    uint64_t version_{0};
+    // Bumped whenever nodes leave the list or lose levels, so that node
+    // pointers kept outside the levels can be checked for staleness.
+    uint64_t removal_epoch_{0};
+
+    std::unique_ptr<LearnedIndex<Node<K, V>>> learned_;
+    uint8_t learned_level_{0};
+    size_t learned_max_error_{0};
+    uint64_t learned_epoch_{0};
+    uint64_t learned_version_{0};
+    size_t learned_elements_{0};
+    size_t learned_debt_{0};
+
+    // Per key_prefix bucket, its first node and the last node at or before
+    // it that reaches radix_level_, or header_; empty when the radix head is
+    // off. Entries of empty buckets are null.
+    struct RadixEntry {
+        Node<K, V>* first_{nullptr};
+        Node<K, V>* finger_{nullptr};
+    };
+    std::vector<RadixEntry> radix_table_;
+    uint8_t radix_bits_{0};
+    uint8_t radix_level_{0};
+    size_t radix_used_{0};
+    size_t radix_fitted_count_{0};
+
+    // Empty when the lookup cache is off.
+    std::vector<CacheEntry> lookup_cache_;
+
+    // Zero when the biased mode is off.
+    uint32_t bias_sample_rate_{0};
+    uint32_t bias_tick_{0};
+    // Sampled nodes only; an entry leaves with its node.
+    struct BiasCount {
+        uint32_t hits_{0};
+        bool promoted_{false};
+    };
+    std::unordered_map<Node<K, V>*, BiasCount> bias_counts_;
+    Node<K, V>* decay_cursor_{nullptr};
+    uint64_t decay_epoch_{0};
+
+    // Keys put at level 0 and the heights still to be built for them.
+    bool lazy_towers_{false};
+    std::deque<std::pair<K, uint8_t>> pending_towers_;
+    std::condition_variable tower_wake_;
+    // Serializes starting and stopping the builder.
+    std::mutex tower_control_;
+    std::thread tower_builder_;
+
+    std::vector<std::pair<size_t, Listener>> listeners_;
+    size_t last_listener_id_{0};
 
     mutable std::mutex mutex_;
     std::mt19937 gen_;
@@ -0,0 +1,124 @@
+// AggregateSkipList range aggregates against a fold over std::map, for the
+// built-in monoids and for string concatenation, which is not commutative
+// and so also checks that spans are combined in key order. Puts that
+// overwrite a value and removes that merge links both change the summaries
+// of every span covering the key.
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+
+#include "aggregate_skip_list.h"
+
+namespace {
+
+using momu::skip_list::AggregateSkipList;
+using momu::skip_list::CountMonoid;
+using momu::skip_list::MaxMonoid;
+using momu::skip_list::MinMonoid;
+using momu::skip_list::SumMonoid;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "aggregate_skip_list_test: %s\n", what);
+    std::abort();
+}
+
+struct ConcatMonoid {
+    using type = std::string;
+    static type identity() { return {}; }
+    static type lift(const std::string& value) { return value; }
+    static type combine(const type& a, const type& b) { return a + b; }
+};
+
+template <typename Monoid, typename V>
+typename Monoid::type fold(const std::map<int, V>& oracle, int from, int to) {
+    auto result = Monoid::identity();
+    for (auto it = oracle.lower_bound(from); it != oracle.end() && it->first < to; ++it)
+        result = Monoid::combine(result, Monoid::lift(it->second));
+    return result;
+}
+
+template <typename Monoid, typename V>
+void check_ranges(AggregateSkipList<int, V, Monoid>& list, const std::map<int, V>& oracle,
+                  int universe, std::mt19937& gen) {
+    check(list.size() == oracle.size(), "size disagrees with the oracle");
+    check(list.aggregate(-1, universe + 1) == fold<Monoid>(oracle, -1, universe + 1),
+          "whole-list aggregate disagrees");
+    check(list.aggregate(5, 5) == Monoid::identity(), "empty range should be the identity");
+    check(list.aggregate(9, 3) == Monoid::identity(), "reversed range should be the identity");
+    for (int i = 0; i < 200; ++i) {
+        int from = static_cast<int>(gen() % (universe + 2)) - 1;
+        int to = from + static_cast<int>(gen() % (gen() % 2 ? 8 : universe));
+        check(list.aggregate(from, to) == fold<Monoid>(oracle, from, to),
+              "range aggregate disagrees");
+    }
+}
+
+template <typename Monoid, typename V, typename MakeValue>
+void run(unsigned seed, MakeValue make_value) {
+    const int universe = 500;
+    std::mt19937 gen(seed);
+    AggregateSkipList<int, V, Monoid> list(10, seed);
+    std::map<int, V> oracle;
+
+    for (int key = 0; key < universe; key += 3) {
+        list.put(key, make_value(gen));
+        oracle[key] = *list.get(key);
+    }
+    check_ranges(list, oracle, universe, gen);
+
+    // Overwrites change the value under every span covering the key.
+    for (int key = 0; key < universe; key += 9) {
+        V value = make_value(gen);
+        list.put(key, value);
+        oracle[key] = value;
+    }
+    check_ranges(list, oracle, universe, gen);
+
+    // Removals merge links, whose summaries must cover both old spans.
+    for (int key = 0; key < universe; key += 6) {
+        check(list.remove(key), "remove missed a live key");
+        oracle.erase(key);
+    }
+    check(!list.remove(0), "remove found a removed key");
+    check_ranges(list, oracle, universe, gen);
+
+    for (int i = 0; i < 4000; ++i) {
+        int key = static_cast<int>(gen() % universe);
+        if (gen() % 3) {
+            V value = make_value(gen);
+            list.put(key, value);
+            oracle[key] = value;
+        } else {
+            check(list.remove(key) == (oracle.erase(key) > 0), "remove disagrees");
+        }
+        if (i % 400 == 0) check_ranges(list, oracle, universe, gen);
+    }
+    check_ranges(list, oracle, universe, gen);
+
+    for (auto it = oracle.begin(); it != oracle.end();) {
+        check(list.remove(it->first), "remove missed a live key");
+        it = oracle.erase(it);
+    }
+    check(list.empty(), "list should be empty after removing everything");
+    check_ranges(list, oracle, universe, gen);
+}
+
+}  // namespace
+
+int main() {
+    auto number = [](std::mt19937& gen) { return static_cast<long>(gen() % 2001) - 1000; };
+    auto letter = [](std::mt19937& gen) { return std::string(1, static_cast<char>('a' + gen() % 26)); };
+    for (unsigned seed = 1; seed <= 6; ++seed) {
+        run<SumMonoid<long>, long>(seed, number);
+        run<MinMonoid<long>, long>(seed, number);
+        run<MaxMonoid<long>, long>(seed, number);
+        run<CountMonoid<long>, long>(seed, number);
+        run<ConcatMonoid, std::string>(seed, letter);
+    }
+    std::printf("aggregate_skip_list_test: ok\n");
+    return 0;
+}
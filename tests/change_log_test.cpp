@@ -0,0 +1,90 @@
+// ChangeLog cursors that fall behind: a cursor parked while the writer
+// laps a small ring, and one polling while another thread laps it
+// continuously, which used to compute the oldest record from a stale head
+// and wrap below zero.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "change_log.h"
+#include "skip_list.h"
+
+namespace {
+
+using momu::skip_list::ChangeLog;
+using momu::skip_list::ChangeRecord;
+using List = momu::skip_list::SkipList<int, int>;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "change_log_test: %s\n", what);
+    std::abort();
+}
+
+void parked_cursor() {
+    List list(8, 1);
+    ChangeLog<int, int> log(list, 4);
+    auto cursor = log.tail();
+    for (int i = 0; i < 100; ++i) list.put(i, i * 2);
+
+    std::vector<ChangeRecord<int, int>> records;
+    check(cursor.poll(records, 16) == 4, "a lapped cursor should get the last 4 records");
+    check(cursor.lost() == 96, "a lapped cursor should count 96 lost records");
+    for (size_t i = 0; i < records.size(); ++i) {
+        check(records[i].sequence_ == 97 + i, "wrong sequence after the lap");
+        check(records[i].key_ == static_cast<int>(96 + i), "wrong key after the lap");
+    }
+    check(cursor.next_sequence() == 101, "cursor should sit after the newest record");
+
+    records.clear();
+    list.remove(99);
+    check(cursor.poll(records, 16) == 1 && !records[0].value_, "cursor missed a removal");
+}
+
+// Every poll must leave the cursor at or before the newest record plus
+// one, and once the writer stops the cursor must catch up to it. A poll
+// that starts while the ring is still filling and is lapped partway
+// through is the case that used to wrap, so each round starts afresh.
+void lapping_writer(unsigned round) {
+    List list(8, round);
+    ChangeLog<int, int> log(list, 4);
+    auto cursor = log.tail();
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (int i = 0; i < 200; ++i) list.put(i % 64, i % 64 * 2);
+        done.store(true);
+    });
+
+    std::vector<ChangeRecord<int, int>> records;
+    uint64_t delivered = 0;
+    uint64_t last = 0;
+    for (bool finished = false; !finished;) {
+        finished = done.load();
+        records.clear();
+        delivered += cursor.poll(records, 1024);
+        for (const auto& record : records) {
+            check(record.sequence_ > last, "records went backwards");
+            check(*record.value_ == record.key_ * 2, "torn record");
+            last = record.sequence_;
+        }
+        check(cursor.next_sequence() <= log.last_sequence() + 1, "cursor ran past the head");
+    }
+    writer.join();
+    records.clear();
+    delivered += cursor.poll(records, 1024);
+    check(cursor.next_sequence() == log.last_sequence() + 1, "cursor went deaf");
+    check(cursor.lost() + delivered == log.last_sequence(),
+          "delivered and lost records do not add up");
+}
+
+}  // namespace
+
+int main() {
+    parked_cursor();
+    for (unsigned round = 0; round < 500; ++round) lapping_writer(round);
+    std::printf("change_log_test: ok\n");
+    return 0;
+}
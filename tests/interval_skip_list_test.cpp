@@ -0,0 +1,131 @@
+// IntervalSkipList queries against a brute-force scan. The queries only
+// descend into links whose max_end_ reaches the query, so a span left
+// stale by a removal or a replaced end either hides intervals or reports
+// ones that do not overlap; both show up as a mismatch here.
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "interval_skip_list.h"
+
+namespace {
+
+using momu::skip_list::Interval;
+using momu::skip_list::IntervalSkipList;
+using List = IntervalSkipList<int, int>;
+using Oracle = std::map<int, std::pair<int, int>>;  // start -> (end, value)
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "interval_skip_list_test: %s\n", what);
+    std::abort();
+}
+
+std::vector<Interval<int, int>> brute_force(const Oracle& oracle, int lo, int hi) {
+    std::vector<Interval<int, int>> out;
+    for (const auto& [start, rest] : oracle) {
+        if (hi < start) break;
+        if (!(rest.first < lo)) out.push_back({start, rest.first, rest.second});
+    }
+    return out;
+}
+
+bool same(const std::vector<Interval<int, int>>& a, const std::vector<Interval<int, int>>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].start_ != b[i].start_ || a[i].end_ != b[i].end_ || a[i].value_ != b[i].value_)
+            return false;
+    }
+    return true;
+}
+
+void check_queries(List& list, const Oracle& oracle, int universe) {
+    check(list.size() == oracle.size(), "size disagrees with the oracle");
+    for (int point = -1; point <= universe + 1; ++point)
+        check(same(list.stab(point), brute_force(oracle, point, point)), "stab disagrees");
+    for (int lo = -1; lo <= universe; lo += 7) {
+        for (int width : {0, 3, 20, universe}) {
+            check(same(list.overlapping(lo, lo + width), brute_force(oracle, lo, lo + width)),
+                  "overlapping disagrees");
+        }
+    }
+}
+
+// Removing the interval with the largest end must let every span that
+// covered it shrink back, and removing the intervals around a long one
+// must make the merged links cover it.
+void removals(unsigned seed) {
+    const int universe = 400;
+    List list(10, seed);
+    Oracle oracle;
+    for (int start = 0; start < universe; start += 2) {
+        int end = start + (start % 50 == 0 ? 150 : start % 7);
+        list.put(start, end, start);
+        oracle[start] = {end, start};
+    }
+    check_queries(list, oracle, universe);
+
+    for (int start = 0; start < universe; start += 50) {
+        check(list.remove(start), "remove missed a long interval");
+        oracle.erase(start);
+        check_queries(list, oracle, universe);
+    }
+    check(!list.remove(0), "remove found a removed interval");
+
+    list.put(100, 390, -1);
+    oracle[100] = {390, -1};
+    for (int start = 2; start < universe; start += 4) {
+        if (start == 100) continue;
+        list.remove(start);
+        oracle.erase(start);
+    }
+    check_queries(list, oracle, universe);
+
+    for (auto it = oracle.begin(); it != oracle.end();) {
+        check(list.remove(it->first), "remove missed a live interval");
+        it = oracle.erase(it);
+    }
+    check(list.empty(), "list should be empty after removing everything");
+    check_queries(list, oracle, universe);
+}
+
+// Random puts (including replacing an existing start with a shorter or
+// longer end) and removes, checking the queries as the spans change.
+void random_ops(unsigned seed) {
+    const int universe = 300;
+    std::mt19937 gen(seed);
+    List list(10, seed);
+    Oracle oracle;
+    for (int i = 0; i < 6000; ++i) {
+        int start = static_cast<int>(gen() % universe);
+        if (gen() % 3) {
+            int end = start + static_cast<int>(gen() % 4 == 0 ? gen() % 120 : gen() % 6);
+            list.put(start, end, i);
+            oracle[start] = {end, i};
+        } else {
+            check(list.remove(start) == (oracle.erase(start) > 0), "remove disagrees");
+        }
+        if (i % 500 == 0) check_queries(list, oracle, universe);
+        auto got = list.get(start);
+        auto it = oracle.find(start);
+        check(got.has_value() == (it != oracle.end()), "get found the wrong intervals");
+        if (got) check(got->end_ == it->second.first && got->value_ == it->second.second,
+                       "get returned the wrong interval");
+    }
+    check_queries(list, oracle, universe);
+}
+
+}  // namespace
+
+int main() {
+    for (unsigned seed = 1; seed <= 8; ++seed) {
+        removals(seed);
+        random_ops(seed);
+    }
+    std::printf("interval_skip_list_test: ok\n");
+    return 0;
+}
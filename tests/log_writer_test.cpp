@@ -0,0 +1,128 @@
+// LogWriter through a temp file, with each backend: flush makes every
+// logged mutation durable, the file replays through ReplicationFollower to
+// the list's contents, a second writer appends behind the first, the
+// destructor writes what is still pending, and a write error fails flush.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+
+#include "log_writer.h"
+#include "replication.h"
+#include "skip_list.h"
+
+namespace {
+
+using momu::skip_list::ReplicationFollower;
+using Writer = momu::skip_list::LogWriter<int, std::string>;
+using List = momu::skip_list::SkipList<int, std::string>;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "log_writer_test: %s\n", what);
+    std::abort();
+}
+
+std::map<int, std::string> contents(List& list) {
+    std::map<int, std::string> out;
+    list.for_each([&out](const int& key, const std::string& value) { out[key] = value; });
+    return out;
+}
+
+struct TempFile {
+    TempFile() {
+        char name[] = "/tmp/log_writer_test.XXXXXX";
+        fd_ = mkstemp(name);
+        check(fd_ >= 0, "mkstemp");
+        path_ = name;
+    }
+    ~TempFile() {
+        close(fd_);
+        unlink(path_.c_str());
+    }
+
+    std::map<int, std::string> replay() {
+        int fd = open(path_.c_str(), O_RDONLY);
+        check(fd >= 0, "reopening the log");
+        List replica(10, 7);
+        ReplicationFollower<int, std::string> follower(replica, fd);
+        check(follower.run(), "the log did not replay");
+        close(fd);
+        return contents(replica);
+    }
+
+    int fd_;
+    std::string path_;
+};
+
+void mutate(List& list, int rounds, int salt) {
+    for (int i = 0; i < rounds; ++i) {
+        int key = (i * 7919 + salt) % 1500;
+        if (i % 4 == 0)
+            list.remove(key);
+        else
+            list.put(key, std::string(static_cast<size_t>(i % 300), 'a' + (i + salt) % 26));
+    }
+}
+
+void write_and_replay(Writer::Backend backend) {
+    TempFile file;
+    List list(10, 1);
+    uint64_t mutations = 0;
+    list.add_listener([&mutations](auto...) { ++mutations; });
+    {
+        // A small buffer makes one batch span several io_uring rounds.
+        Writer writer(list, file.fd_, backend, 4096);
+        check(backend == Writer::Backend::kIoUring || writer.backend() == Writer::Backend::kSync,
+              "the sync backend was not honoured");
+        mutate(list, 5000, 0);
+        check(writer.flush(), "flush failed");
+        check(writer.durable_sequence() == writer.appended_sequence(),
+              "flush returned before everything was durable");
+        check(writer.appended_sequence() == mutations, "a mutation was not logged");
+        check(file.replay() == contents(list), "the flushed log does not match the list");
+
+        // Left pending for the destructor.
+        mutate(list, 3000, 11);
+    }
+    check(file.replay() == contents(list), "the destructor did not write the tail");
+
+    // A second writer appends at the end of the existing log.
+    {
+        Writer writer(list, file.fd_, backend);
+        mutate(list, 2000, 23);
+        check(writer.flush(), "flush failed on the second writer");
+    }
+    check(file.replay() == contents(list), "the appended log does not match the list");
+}
+
+void write_error(Writer::Backend backend) {
+    TempFile file;
+    int read_only = open(file.path_.c_str(), O_RDONLY);
+    check(read_only >= 0, "opening the log read-only");
+    List list(10, 2);
+    {
+        Writer writer(list, read_only, backend);
+        list.put(1, "one");
+        check(!writer.flush(), "flush should fail after a write error");
+        list.put(2, "two");
+        check(!writer.flush(), "flush should keep failing");
+    }
+    close(read_only);
+}
+
+}  // namespace
+
+int main() {
+    for (auto backend : {Writer::Backend::kSync, Writer::Backend::kIoUring}) {
+        write_and_replay(backend);
+        write_error(backend);
+    }
+    std::printf("log_writer_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Differential test of PostingList against std::set: random inserts and
+// removes over id mixes that exercise every bit width (dense runs, small
+// gaps, gaps up to the full 64 bits), block splits and merges, decoding
+// through to_vector and contains, and intersections whose blocks overlap
+// at random boundaries, so both the skipping and the decoding paths run.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "posting_list.h"
+
+namespace {
+
+using momu::skip_list::PostingList;
+using Oracle = std::set<uint64_t>;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "posting_list_test: %s disagrees with the oracle\n", what);
+    std::abort();
+}
+
+// Ids from a mix of dense runs, small gaps and arbitrary 64-bit values.
+uint64_t random_id(std::mt19937_64& gen, uint64_t base) {
+    switch (gen() % 4) {
+        case 0:
+            return base + gen() % 256;
+        case 1:
+            return base + (gen() % 64) * 37;
+        case 2:
+            return gen();
+        default:
+            return gen() % 2 ? std::numeric_limits<uint64_t>::max() - gen() % 4 : gen() % 4;
+    }
+}
+
+void check_contents(PostingList& list, const Oracle& oracle) {
+    check(list.size() == oracle.size(), "size");
+    auto ids = list.to_vector();
+    check(std::equal(ids.begin(), ids.end(), oracle.begin(), oracle.end()), "to_vector");
+}
+
+void differential(unsigned seed) {
+    std::mt19937_64 gen(seed);
+    PostingList list(12, seed);
+    Oracle oracle;
+    uint64_t base = gen() % 1000000;
+    for (int i = 0; i < 20000; ++i) {
+        uint64_t id = random_id(gen, base);
+        switch (gen() % 5) {
+            case 0:
+            case 1:
+                check(list.insert(id) == oracle.insert(id).second, "insert");
+                break;
+            case 2: {
+                // Removing existing ids drains blocks until they merge.
+                auto it = oracle.lower_bound(id);
+                if (it != oracle.end() && gen() % 2) id = *it;
+                check(list.remove(id) == (oracle.erase(id) > 0), "remove");
+                break;
+            }
+            case 3:
+                check(list.contains(id) == (oracle.count(id) > 0), "contains");
+                break;
+            case 4:
+                if (gen() % 64 == 0) check_contents(list, oracle);
+                break;
+        }
+    }
+    check_contents(list, oracle);
+    for (uint64_t id : oracle) check(list.contains(id), "contains after the run");
+}
+
+// The two sides share some ranges and not others, with runs of different
+// density, so blocks start and end at unrelated ids on each side.
+void intersection(unsigned seed) {
+    std::mt19937_64 gen(seed);
+    PostingList lhs(12, seed), rhs(12, seed + 1);
+    Oracle a, b;
+    for (int range = 0; range < 40; ++range) {
+        uint64_t start = gen() % 100000;
+        uint64_t stride_a = 1 + gen() % 8, stride_b = 1 + gen() % 8;
+        size_t len = gen() % 600;
+        bool in_a = gen() % 4 != 0, in_b = gen() % 4 != 0;
+        for (size_t i = 0; i < len; ++i) {
+            if (in_a) {
+                lhs.insert(start + i * stride_a);
+                a.insert(start + i * stride_a);
+            }
+            if (in_b) {
+                rhs.insert(start + i * stride_b);
+                b.insert(start + i * stride_b);
+            }
+        }
+    }
+    std::vector<uint64_t> expected;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+
+    std::vector<uint64_t> out{42};
+    set_intersection(lhs, rhs, out);
+    check(out.front() == 42, "intersection should append to out");
+    out.erase(out.begin());
+    check(out == expected, "set_intersection");
+
+    out.clear();
+    set_intersection(rhs, lhs, out);
+    check(out == expected, "set_intersection with the sides swapped");
+
+    out.clear();
+    set_intersection(lhs, lhs, out);
+    check(std::equal(out.begin(), out.end(), a.begin(), a.end()), "self intersection");
+
+    PostingList empty(12, seed);
+    out.clear();
+    set_intersection(lhs, empty, out);
+    check(out.empty(), "intersection with an empty list");
+}
+
+}  // namespace
+
+int main() {
+    for (unsigned seed = 1; seed <= 20; ++seed) {
+        differential(seed);
+        intersection(seed);
+    }
+    std::printf("posting_list_test: ok\n");
+    return 0;
+}
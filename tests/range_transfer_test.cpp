@@ -0,0 +1,241 @@
+// RangeExporter/RangeImporter through a temp file: ranges round-trip with
+// and without prefix compression and across many blocks, and the CRCs catch
+// a flipped byte. A flipped payload byte fails one block, which an importer
+// with skip_corrupt salvages around; a flipped byte in either CRC field
+// fails the header, after which nothing more can be trusted; and a
+// truncated image is reported as incomplete.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "codec.h"
+#include "range_transfer.h"
+#include "skip_list.h"
+
+namespace {
+
+using momu::skip_list::get_fixed32;
+using momu::skip_list::kRangeBlockHeaderBytes;
+using momu::skip_list::RangeExporter;
+using momu::skip_list::RangeImageChecker;
+using momu::skip_list::RangeImporter;
+using List = momu::skip_list::SkipList<std::string, std::string>;
+using Map = std::map<std::string, std::string>;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "range_transfer_test: %s\n", what);
+    std::abort();
+}
+
+Map contents(List& list) {
+    Map out;
+    list.for_each([&out](const std::string& key, const std::string& value) { out[key] = value; });
+    return out;
+}
+
+// A range image in a temp file, which tests read back and rewrite.
+class Image {
+   public:
+    Image() {
+        char name[] = "/tmp/range_transfer_test.XXXXXX";
+        fd_ = mkstemp(name);
+        check(fd_ >= 0, "mkstemp");
+        path_ = name;
+    }
+    ~Image() {
+        close(fd_);
+        unlink(path_.c_str());
+    }
+
+    int fd() const { return fd_; }
+
+    std::string bytes() {
+        std::string out(static_cast<size_t>(lseek(fd_, 0, SEEK_END)), '\0');
+        check(pread(fd_, out.data(), out.size(), 0) == static_cast<ssize_t>(out.size()),
+              "reading the image");
+        return out;
+    }
+
+    void rewrite(const std::string& data) {
+        check(ftruncate(fd_, 0) == 0, "truncating the image");
+        check(pwrite(fd_, data.data(), data.size(), 0) == static_cast<ssize_t>(data.size()),
+              "rewriting the image");
+    }
+
+    // Every reader starts at the beginning.
+    int rewound() {
+        check(lseek(fd_, 0, SEEK_SET) == 0, "rewinding the image");
+        return fd_;
+    }
+
+   private:
+    int fd_;
+    std::string path_;
+};
+
+std::string key_of(int i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "user/%04d/item/%03d", i / 50, i % 50);
+    return buf;
+}
+
+void fill(List& list, int entries) {
+    for (int i = 0; i < entries; ++i)
+        list.put(key_of(i),
+                 std::string(static_cast<size_t>(i % 97), static_cast<char>('a' + i % 26)));
+}
+
+Map expected_range(List& list, const std::string& from, const std::string& to) {
+    Map out;
+    for (const auto& [key, value] : contents(list)) {
+        if (!(key < from) && key < to) out[key] = value;
+    }
+    return out;
+}
+
+void round_trip(bool prefix_compression, size_t block_size) {
+    List source(12, 1);
+    fill(source, 3000);
+    for (auto [from, to] : {std::pair<std::string, std::string>{"", "~"},
+                            {key_of(130), key_of(2217)},
+                            {key_of(500), key_of(500)},
+                            {"zzz", "~"}}) {
+        Image image;
+        RangeExporter<std::string, std::string> exporter(source, block_size, prefix_compression);
+        check(exporter.write(from, to, image.fd()), "export failed");
+
+        RangeImageChecker checker;
+        auto expected = expected_range(source, from, to);
+        check(checker.check(image.rewound()) && checker.complete(), "the image should be intact");
+        check(checker.entries() == expected.size(), "the checker counted the wrong entries");
+
+        List target(12, 2);
+        RangeImporter<std::string, std::string> importer(target);
+        check(importer.read(image.rewound()), "import failed");
+        check(importer.imported() == expected.size(), "imported the wrong number of entries");
+        check(contents(target) == expected, "the range did not round-trip");
+    }
+}
+
+// Header offsets and entry counts of the first three blocks of an image.
+struct Layout {
+    size_t block_[3];
+    uint32_t count_[3];
+};
+
+Layout layout_of(const std::string& bytes) {
+    Layout layout{};
+    size_t at = 0;
+    for (int i = 0; i < 3; ++i) {
+        check(at + kRangeBlockHeaderBytes <= bytes.size(), "the image has too few blocks");
+        layout.block_[i] = at;
+        layout.count_[i] = get_fixed32(bytes.data() + at + 4);
+        at += kRangeBlockHeaderBytes + get_fixed32(bytes.data() + at);
+    }
+    return layout;
+}
+
+void corruption() {
+    List source(12, 3);
+    fill(source, 2000);
+    Image image;
+    RangeExporter<std::string, std::string> exporter(source, 2048);
+    check(exporter.write("", "~", image.fd()), "export failed");
+    const std::string pristine = image.bytes();
+    const Layout layout = layout_of(pristine);
+    const size_t total = source.size();
+
+    // A flipped payload byte in the second block.
+    std::string bad = pristine;
+    bad[layout.block_[1] + kRangeBlockHeaderBytes + 5] ^= 0x20;
+    image.rewrite(bad);
+    {
+        List target(12, 4);
+        RangeImporter<std::string, std::string> strict(target);
+        check(!strict.read(image.rewound()), "a corrupt payload should fail a strict import");
+        check(strict.corrupt_blocks() == 1, "the strict import should count the block");
+        check(strict.imported() == layout.count_[0], "the strict import should stop there");
+    }
+    {
+        List target(12, 4);
+        RangeImporter<std::string, std::string> salvage(target, true);
+        check(salvage.read(image.rewound()), "a salvaging import should finish");
+        check(salvage.corrupt_blocks() == 1, "the salvaging import should count the block");
+        check(salvage.imported() == total - layout.count_[1],
+              "the salvaging import should skip exactly the corrupt block");
+        RangeImageChecker checker;
+        check(!checker.check(image.rewound()), "the checker missed a corrupt payload");
+        check(checker.corrupt_blocks() == 1 && checker.complete(),
+              "the checker should count one corrupt block and still reach the end");
+    }
+
+    // A flipped byte in the payload CRC, and one in the header CRC itself.
+    for (size_t field : {size_t{8}, size_t{12}}) {
+        bad = pristine;
+        bad[layout.block_[2] + field + 1] ^= 0x01;
+        image.rewrite(bad);
+        List target(12, 5);
+        RangeImporter<std::string, std::string> salvage(target, true);
+        check(!salvage.read(image.rewound()), "a corrupt header should fail the import");
+        check(salvage.imported() == layout.count_[0] + layout.count_[1],
+              "blocks before a corrupt header should import");
+        RangeImageChecker checker;
+        check(!checker.check(image.rewound()) && !checker.complete(),
+              "the checker missed a corrupt header");
+    }
+
+    // Cut off inside a payload, and just before the end marker.
+    for (size_t cut : {layout.block_[1] + kRangeBlockHeaderBytes + 3,
+                       pristine.size() - kRangeBlockHeaderBytes}) {
+        image.rewrite(pristine.substr(0, cut));
+        List target(12, 6);
+        RangeImporter<std::string, std::string> importer(target, true);
+        check(!importer.read(image.rewound()), "a truncated image should fail the import");
+        RangeImageChecker checker;
+        check(!checker.check(image.rewound()) && !checker.complete(),
+              "the checker missed a truncated image");
+    }
+
+    image.rewrite(pristine);
+    RangeImageChecker checker;
+    check(checker.check(image.rewound()) && checker.entries() == total,
+          "the restored image should check clean");
+}
+
+void integer_keys() {
+    momu::skip_list::SkipList<uint64_t, uint64_t> source(12, 7), target(12, 8);
+    for (uint64_t i = 0; i < 5000; ++i) source.put(i * 0x9e3779b97f4a7c15ull, i);
+    Image image;
+    RangeExporter<uint64_t, uint64_t> exporter(source, 512);
+    check(exporter.write(0, ~uint64_t{0}, image.fd()), "export failed");
+    RangeImporter<uint64_t, uint64_t> importer(target);
+    check(importer.read(image.rewound()), "import failed");
+    size_t matched = 0;
+    source.for_each([&](const uint64_t& key, const uint64_t& value) {
+        auto got = target.get(key);
+        if (got && *got == value) ++matched;
+    });
+    check(matched == source.size() && target.size() == source.size(),
+          "integer keys did not round-trip");
+}
+
+}  // namespace
+
+int main() {
+    for (bool prefix_compression : {true, false}) {
+        for (size_t block_size : {size_t{1}, size_t{700}, size_t{64 * 1024}})
+            round_trip(prefix_compression, block_size);
+    }
+    corruption();
+    integer_keys();
+    std::printf("range_transfer_test: ok\n");
+    return 0;
+}
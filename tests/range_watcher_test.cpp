@@ -0,0 +1,163 @@
+// RangeWatcher callbacks: each subscriber sees exactly the puts and removes
+// inside its closed range, in mutation order, including subscribers that
+// share a start key and so share one interval in the index; unwatching one
+// leaves the others alone, a full queue drops and counts events instead of
+// blocking the writer, and events already queued are delivered on stop.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "range_watcher.h"
+#include "skip_list.h"
+
+namespace {
+
+using momu::skip_list::Mutation;
+using momu::skip_list::RangeWatcher;
+using momu::skip_list::WatchEvent;
+using List = momu::skip_list::SkipList<int, int>;
+using Event = WatchEvent<int, int>;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "range_watcher_test: %s\n", what);
+    std::abort();
+}
+
+// Events recorded by one subscriber's callback, which runs on its thread.
+struct Recorder {
+    RangeWatcher<int, int>::Callback callback() {
+        return [this](const Event& event) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            events_.push_back(event);
+        };
+    }
+
+    std::vector<Event> events() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return events_;
+    }
+
+    std::mutex mutex_;
+    std::vector<Event> events_;
+};
+
+struct Range {
+    int from_;
+    int to_;
+};
+
+bool same(const std::vector<Event>& a, const std::vector<Event>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].op_ != b[i].op_ || a[i].key_ != b[i].key_ || a[i].value_ != b[i].value_)
+            return false;
+    }
+    return true;
+}
+
+void ranges() {
+    const std::vector<Range> watched = {{10, 20}, {15, 30}, {15, 25}, {40, 40}, {-5, 100}};
+    List list(8, 1);
+    std::vector<Recorder> recorders(watched.size());
+    std::vector<std::vector<Event>> expected(watched.size());
+    std::vector<Event> log;
+    {
+        RangeWatcher<int, int> watcher(list, 1 << 12);
+        for (size_t i = 0; i < watched.size(); ++i)
+            watcher.watch(watched[i].from_, watched[i].to_, recorders[i].callback());
+
+        for (int key = 0; key <= 50; ++key) {
+            list.put(key, key * 3);
+            log.push_back({Mutation::kPut, key, key * 3});
+        }
+        for (int key = 0; key <= 50; key += 5) {
+            list.put(key, -key);
+            log.push_back({Mutation::kPut, key, -key});
+        }
+        for (int key = 0; key <= 50; key += 2) {
+            list.remove(key);
+            log.push_back({Mutation::kRemove, key, std::nullopt});
+        }
+        check(!list.remove(2), "second remove of a key should fail");
+        // The destructor stops every subscriber after it drains its queue.
+    }
+    list.put(12, 0);
+
+    for (const auto& event : log) {
+        for (size_t i = 0; i < watched.size(); ++i) {
+            if (watched[i].from_ <= event.key_ && event.key_ <= watched[i].to_)
+                expected[i].push_back(event);
+        }
+    }
+    for (size_t i = 0; i < watched.size(); ++i)
+        check(same(recorders[i].events(), expected[i]), "subscriber saw the wrong events");
+}
+
+void unwatch() {
+    List list(8, 2);
+    Recorder narrow, wide, other;
+    RangeWatcher<int, int> watcher(list);
+    size_t narrow_id = watcher.watch(5, 6, narrow.callback());
+    size_t wide_id = watcher.watch(5, 9, wide.callback());
+    watcher.watch(7, 8, other.callback());
+
+    list.put(5, 1);
+    check(watcher.unwatch(wide_id), "unwatch missed a subscription");
+    check(!watcher.unwatch(wide_id), "unwatch found a removed subscription");
+    check(!watcher.unwatch(12345), "unwatch found an unknown id");
+    check(wide.events().size() == 1, "unwatch should deliver queued events");
+
+    // The group for start 5 now ends at 6, so 8 reaches only the other one.
+    list.put(8, 2);
+    list.put(6, 3);
+    check(watcher.unwatch(narrow_id), "unwatch missed the last group member");
+    list.put(5, 4);
+
+    check(wide.events().size() == 1, "an unwatched subscriber got an event");
+    auto got = narrow.events();
+    check(got.size() == 2 && got[0].key_ == 5 && got[1].key_ == 6,
+          "group member lost events when its neighbour left");
+    check(watcher.dropped(narrow_id) == 0, "dropped of a removed id should be 0");
+}
+
+// A subscriber stuck in its callback holds at most the one event it is
+// delivering plus a full queue; everything else is dropped and counted.
+void overflow() {
+    const int kEvents = 10;
+    const size_t kCapacity = 2;
+    List list(8, 3);
+    std::promise<void> release;
+    std::shared_future<void> gate = release.get_future().share();
+    std::atomic<int> delivered{0};
+    RangeWatcher<int, int> watcher(list, kCapacity);
+    size_t id = watcher.watch(0, kEvents, [&](const Event&) {
+        gate.wait();
+        ++delivered;
+    });
+
+    for (int key = 0; key < kEvents; ++key) list.put(key, key);
+    size_t dropped = watcher.dropped(id);
+    check(dropped >= kEvents - kCapacity - 1, "a full queue should drop events");
+    release.set_value();
+    check(watcher.unwatch(id), "unwatch missed the subscription");
+    check(delivered + dropped == kEvents, "delivered and dropped events do not add up");
+}
+
+}  // namespace
+
+int main() {
+    for (int round = 0; round < 20; ++round) {
+        ranges();
+        unwatch();
+        overflow();
+    }
+    std::printf("range_watcher_test: ok\n");
+    return 0;
+}
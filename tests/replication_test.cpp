@@ -0,0 +1,228 @@
+// Replication frames and the primary/follower pair. The codec helpers and
+// encode_mutation frames round-trip through ReplicationFollower, which must
+// reject malformed and truncated streams; a follower added to a primary
+// that already holds data and keeps mutating must converge on the primary;
+// and destroying the primary must not hang on a peer that stopped reading.
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "codec.h"
+#include "replication.h"
+#include "skip_list.h"
+
+namespace {
+
+using momu::skip_list::Codec;
+using momu::skip_list::crc32c;
+using momu::skip_list::encode_mutation;
+using momu::skip_list::get_fixed32;
+using momu::skip_list::get_varint32;
+using momu::skip_list::Mutation;
+using momu::skip_list::put_fixed32;
+using momu::skip_list::put_varint32;
+using momu::skip_list::ReplicationFollower;
+using momu::skip_list::ReplicationOp;
+using momu::skip_list::ReplicationPrimary;
+using List = momu::skip_list::SkipList<int, std::string>;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "replication_test: %s\n", what);
+    std::abort();
+}
+
+std::map<int, std::string> contents(List& list) {
+    std::map<int, std::string> out;
+    list.for_each([&out](const int& key, const std::string& value) { out[key] = value; });
+    return out;
+}
+
+void codecs() {
+    std::string out;
+    for (uint32_t v : {0u, 1u, 127u, 128u, 300u, 1u << 21, 0xffffffffu}) {
+        out.clear();
+        put_varint32(out, v);
+        const char* p = out.data();
+        uint32_t got = 0;
+        check(get_varint32(p, out.data() + out.size(), got) && got == v,
+              "varint32 round-trip");
+        check(p == out.data() + out.size(), "varint32 left bytes behind");
+        p = out.data();
+        check(out.size() == 1 || !get_varint32(p, out.data() + out.size() - 1, got),
+              "truncated varint32 should fail");
+
+        out.clear();
+        put_fixed32(out, v);
+        check(out.size() == 4 && get_fixed32(out.data()) == v, "fixed32 round-trip");
+    }
+    std::string too_long(5, '\xff');
+    const char* p = too_long.data();
+    uint32_t got = 0;
+    check(!get_varint32(p, too_long.data() + too_long.size(), got),
+          "a six-byte varint32 should fail");
+
+    // The standard CRC-32C check value, whole and fed in two pieces.
+    const char digits[] = "123456789";
+    check(crc32c(digits, 9) == 0xe3069283u, "crc32c check value");
+    check(crc32c(digits + 4, 5, crc32c(digits, 4)) == 0xe3069283u,
+          "crc32c should continue across pieces");
+
+    int key = 0;
+    out.clear();
+    Codec<int>::encode(-42, out);
+    check(Codec<int>::decode(out.data(), out.size(), key) && key == -42, "int codec");
+    check(!Codec<int>::decode(out.data(), out.size() - 1, key), "short int should fail");
+}
+
+// Writes frames into a pipe and applies them with a follower.
+bool replay(const std::string& stream, List& list) {
+    int fds[2];
+    check(pipe(fds) == 0, "pipe");
+    std::thread writer([&] {
+        check(write(fds[1], stream.data(), stream.size()) ==
+                  static_cast<ssize_t>(stream.size()),
+              "short write to the pipe");
+        close(fds[1]);
+    });
+    ReplicationFollower<int, std::string> follower(list, fds[0]);
+    bool ok = follower.run();
+    writer.join();
+    close(fds[0]);
+    return ok;
+}
+
+void frames() {
+    std::string stream;
+    std::string empty, big(100000, 'v');
+    auto put = [&](int key, const std::string& value) {
+        stream += encode_mutation<Codec<int>, Codec<std::string>>(Mutation::kPut, key, &value);
+    };
+    put(1, "one");
+    put(2, empty);
+    put(3, big);
+    put(1, "uno");
+    stream += encode_mutation<Codec<int>, Codec<std::string>>(
+        Mutation::kRemove, 2, static_cast<const std::string*>(nullptr));
+    stream += static_cast<char>(ReplicationOp::kSnapshotEnd);
+
+    List list(8, 1);
+    check(replay(stream, list), "a well-formed stream should apply");
+    auto got = contents(list);
+    check(got.size() == 2 && got[1] == "uno" && got[3] == big, "frames did not round-trip");
+
+    List truncated(8, 1);
+    check(!replay(stream.substr(0, stream.size() / 2), truncated),
+          "a truncated stream should fail");
+
+    List malformed(8, 1);
+    check(!replay(std::string(1, '\x09'), malformed), "an unknown op should fail");
+
+    // A key field whose length does not match sizeof(int).
+    std::string bad_key(1, static_cast<char>(ReplicationOp::kRemove));
+    put_fixed32(bad_key, 3);
+    bad_key += "abc";
+    check(!replay(bad_key, malformed), "a malformed key should fail");
+}
+
+// The follower joins while the primary already holds data and keeps
+// taking writes, so part of the tail overlaps the snapshot.
+void catch_up(unsigned seed) {
+    List primary_list(10, seed);
+    for (int key = 0; key < 2000; ++key) primary_list.put(key, "v" + std::to_string(key));
+
+    int fds[2];
+    check(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0, "socketpair");
+    List replica(10, seed + 1);
+    ReplicationFollower<int, std::string> follower(replica, fds[1]);
+    bool follower_ok = false;
+    std::thread reader([&] { follower_ok = follower.run(); });
+
+    {
+        ReplicationPrimary<int, std::string> primary(primary_list);
+        std::thread writer([&] {
+            for (int i = 0; i < 4000; ++i) {
+                int key = (i * 7919) % 3000;
+                if (i % 3 == 0)
+                    primary_list.remove(key);
+                else
+                    primary_list.put(key, "w" + std::to_string(i));
+            }
+        });
+        primary.add_follower(fds[0]);
+        writer.join();
+        check(primary.follower_count() == 1, "a healthy follower was dropped");
+    }
+    shutdown(fds[0], SHUT_WR);
+    reader.join();
+    close(fds[0]);
+    close(fds[1]);
+
+    check(follower_ok, "the follower rejected the stream");
+    check(follower.caught_up(), "the follower never saw the end of the snapshot");
+    check(contents(replica) == contents(primary_list), "the follower did not converge");
+}
+
+// A peer that stops reading leaves the sender blocked in send() once the
+// socket buffer fills; the destructor must shut the socket down after the
+// stall timeout instead of joining forever, which the alarm turns into a
+// failure. A reader slow enough to outlast the stall timeout but still
+// draining must get everything queued.
+void stalled_peer() {
+    const int kEntries = 2000;
+    const std::string value(1000, 'x');
+    for (bool reading : {false, true}) {
+        List primary_list(10, 1);
+        int fds[2];
+        check(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0, "socketpair");
+        int small = 4096;
+        setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+
+        std::thread reader;
+        size_t received = 0;
+        alarm(30);
+        {
+            ReplicationPrimary<int, std::string> primary(primary_list);
+            primary.add_follower(fds[0]);
+            for (int key = 0; key < kEntries; ++key) primary_list.put(key, value);
+            if (reading) {
+                reader = std::thread([&] {
+                    char chunk[512];
+                    for (ssize_t n; (n = read(fds[1], chunk, sizeof(chunk))) > 0;) {
+                        received += static_cast<size_t>(n);
+                        std::this_thread::sleep_for(std::chrono::microseconds(500));
+                    }
+                });
+            }
+        }
+        alarm(0);
+        shutdown(fds[0], SHUT_WR);
+        if (reading) {
+            reader.join();
+            size_t frame = encode_mutation<Codec<int>, Codec<std::string>>(
+                               Mutation::kPut, 0, &value).size();
+            check(received == 1 + kEntries * frame, "a slow reader lost queued frames");
+        }
+        close(fds[0]);
+        close(fds[1]);
+    }
+}
+
+}  // namespace
+
+int main() {
+    codecs();
+    frames();
+    for (unsigned seed = 1; seed <= 10; ++seed) catch_up(seed);
+    stalled_peer();
+    std::printf("replication_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,213 @@
+// Differential fuzz driver: reads its input as a sequence of operations,
+// applies them both to a SkipList and to a std::map oracle, and aborts on
+// any disagreement. Built with MOMU_SKIP_LIST_CHECK_INVARIANTS, so every
+// mutation also runs a full verify(). As a libFuzzer target
+// (MOMU_SKIP_LIST_LIBFUZZER) it only defines LLVMFuzzerTestOneInput;
+// otherwise main feeds it random inputs:
+//
+//     skip_list_fuzz [iterations] [seed]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "skip_list.h"
+
+namespace {
+
+using List = momu::skip_list::SkipList<int, int>;
+using Oracle = std::map<int, int>;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "skip_list_fuzz: %s disagrees with the oracle\n", what);
+    std::abort();
+}
+
+class Input {
+   public:
+    Input(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    bool done() const { return pos_ >= size_; }
+    uint8_t byte() { return pos_ < size_ ? data_[pos_++] : 0; }
+    // Few enough keys that operations keep hitting each other, some negative.
+    int key() { return static_cast<int>(byte()) - 64; }
+
+   private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_{0};
+};
+
+void check_contents(List& list, const Oracle& oracle) {
+    check(list.size() == oracle.size(), "size");
+    auto it = oracle.begin();
+    bool ok = true;
+    list.for_each([&](const int& key, const int& value) {
+        ok = ok && it != oracle.end() && it->first == key && it->second == value;
+        if (it != oracle.end()) ++it;
+    });
+    check(ok && it == oracle.end(), "for_each");
+    check(list.verify(), "verify");
+}
+
+void check_scan(List& list, const Oracle& oracle, int from, size_t limit) {
+    auto it = oracle.lower_bound(from);
+    bool ok = true;
+    size_t seen = 0;
+    list.scan(from, [&](const int& key, const int& value) {
+        ok = ok && it != oracle.end() && it->first == key && it->second == value;
+        if (it != oracle.end()) ++it;
+        return ++seen < limit;
+    });
+    check(ok && (seen == limit || it == oracle.end()), "scan");
+}
+
+// On equal keys the merged-in list's value wins.
+void merge_from(List& list, Oracle& oracle, Input& in, bool parallel) {
+    List other(12, in.byte());
+    for (int n = in.byte() % 32; n > 0; --n) {
+        int key = in.key();
+        int value = in.byte();
+        other.put(key, value);
+        oracle[key] = value;
+    }
+    if (parallel)
+        list.merge_parallel(std::move(other), in.byte() % 4 + 1);
+    else
+        list.merge(std::move(other));
+    check(other.empty() && other.verify(), "merged-from list");
+}
+
+void toggle_mode(List& list, Input& in) {
+    uint8_t mode = in.byte();
+    bool enable = in.byte() & 1;
+    uint8_t arg = in.byte();
+    switch (mode % 5) {
+        case 0:
+            if (enable)
+                list.enable_learned_index(arg % 4 + 1, in.byte() % 32);
+            else
+                list.disable_learned_index();
+            break;
+        case 1:
+            if (enable)
+                list.enable_radix_head(arg % 12 + 1);
+            else
+                list.disable_radix_head();
+            break;
+        case 2:
+            if (enable)
+                list.enable_biased(arg % 4 + 1);
+            else
+                list.disable_biased();
+            break;
+        case 3:
+            if (enable)
+                list.enable_lookup_cache(arg % 64 + 1);
+            else
+                list.disable_lookup_cache();
+            break;
+        case 4:
+            if (enable)
+                list.enable_lazy_towers(std::chrono::microseconds(arg + 1));
+            else
+                list.disable_lazy_towers();
+            break;
+    }
+}
+
+void run(const uint8_t* data, size_t size) {
+    Input in(data, size);
+    List list(12, in.byte());
+    Oracle oracle;
+    while (!in.done()) {
+        switch (in.byte() % 12) {
+            case 0:
+            case 1:
+            case 2: {
+                int key = in.key();
+                int value = in.byte();
+                list.put(key, value);
+                oracle[key] = value;
+                break;
+            }
+            case 3: {
+                int key = in.key();
+                check(list.remove(key) == (oracle.erase(key) > 0), "remove");
+                break;
+            }
+            case 4: {
+                int key = in.key();
+                auto found = list.get(key);
+                auto it = oracle.find(key);
+                check(found ? it != oracle.end() && it->second == *found : it == oracle.end(),
+                      "get");
+                break;
+            }
+            case 5: {
+                int key = in.key();
+                check(list.contains(key) == (oracle.count(key) > 0), "contains");
+                break;
+            }
+            case 6: {
+                int key = in.key();
+                auto end = oracle.lower_bound(key);
+                auto expected = static_cast<size_t>(std::distance(oracle.begin(), end));
+                check(list.trim_before(key) == expected, "trim_before");
+                oracle.erase(oracle.begin(), end);
+                break;
+            }
+            case 7:
+                merge_from(list, oracle, in, false);
+                break;
+            case 8:
+                merge_from(list, oracle, in, true);
+                break;
+            case 9: {
+                int from = in.key();
+                check_scan(list, oracle, from, in.byte() % 8 + 1);
+                break;
+            }
+            case 10:
+                toggle_mode(list, in);
+                break;
+            case 11:
+                check_contents(list, oracle);
+                break;
+        }
+    }
+    check_contents(list, oracle);
+}
+
+}  // namespace
+
+#ifdef MOMU_SKIP_LIST_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    run(data, size);
+    return 0;
+}
+
+#else
+
+int main(int argc, char** argv) {
+    long iterations = argc > 1 ? std::atol(argv[1]) : 1000;
+    auto seed = static_cast<unsigned>(argc > 2 ? std::atol(argv[2]) : std::random_device{}());
+    std::printf("skip_list_fuzz: %ld inputs, seed %u\n", iterations, seed);
+    std::mt19937 gen(seed);
+    std::vector<uint8_t> input;
+    for (long i = 0; i < iterations; ++i) {
+        input.resize(gen() % 4096);
+        for (auto& b : input) b = static_cast<uint8_t>(gen());
+        run(input.data(), input.size());
+    }
+    return 0;
+}
+
+#endif
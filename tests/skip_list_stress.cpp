@@ -0,0 +1,195 @@
+// Concurrent stress test, meant to run under ThreadSanitizer. Workers mix
+// puts, removes, lookups and scans on one list while another thread keeps
+// switching the optional lookup structures, lazy towers and biased mode on
+// and off and merges and trims, a verifier walks the list in small
+// budgeted steps, and a ChangeLog cursor tails every mutation. A final
+// phase records a history on a few keys and checks it is linearizable.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "change_log.h"
+#include "linearizability.h"
+#include "skip_list.h"
+
+namespace {
+
+using momu::skip_list::ChangeLog;
+using momu::skip_list::ChangeRecord;
+using momu::skip_list::HistoryRecorder;
+using momu::skip_list::VerifyResult;
+using List = momu::skip_list::SkipList<int, int>;
+
+constexpr int kWorkers = 4;
+constexpr int kOpsPerWorker = 20000;
+constexpr int kKeys = 4096;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "skip_list_stress: %s\n", what);
+    std::abort();
+}
+
+void work(List& list, unsigned seed) {
+    std::mt19937 gen(seed);
+    for (int i = 0; i < kOpsPerWorker; ++i) {
+        int key = static_cast<int>(gen() % kKeys);
+        switch (gen() % 6) {
+            case 0:
+            case 1:
+                list.put(key, key * 2);
+                break;
+            case 2:
+                list.remove(key);
+                break;
+            case 3:
+                if (auto value = list.get(key)) check(*value == key * 2, "get saw a wrong value");
+                break;
+            case 4:
+                list.contains(key);
+                break;
+            case 5: {
+                int last = key - 1;
+                int seen = 0;
+                list.scan(key, [&](const int& k, const int& v) {
+                    check(last < k && v == k * 2, "scan out of order");
+                    last = k;
+                    return ++seen < 16;
+                });
+                break;
+            }
+        }
+    }
+}
+
+void reconfigure(List& list, const std::atomic<bool>& done) {
+    std::mt19937 gen(7);
+    while (!done.load()) {
+        bool enable = gen() & 1;
+        switch (gen() % 7) {
+            case 0:
+                enable ? list.enable_learned_index(2) : list.disable_learned_index();
+                break;
+            case 1:
+                enable ? list.enable_radix_head(8) : list.disable_radix_head();
+                break;
+            case 2:
+                enable ? list.enable_biased(4) : list.disable_biased();
+                break;
+            case 3:
+                enable ? list.enable_lookup_cache(256) : list.disable_lookup_cache();
+                break;
+            case 4:
+                enable ? list.enable_lazy_towers(std::chrono::microseconds(100))
+                       : list.disable_lazy_towers();
+                break;
+            case 5: {
+                List other(16, gen());
+                for (int i = 0; i < 64; ++i) {
+                    int key = static_cast<int>(gen() % kKeys);
+                    other.put(key, key * 2);
+                }
+                if (enable)
+                    list.merge_parallel(std::move(other), 3);
+                else
+                    list.merge(std::move(other));
+                break;
+            }
+            case 6:
+                list.trim_before(static_cast<int>(gen() % 64), enable);
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    list.disable_lazy_towers();
+}
+
+void verify_continuously(List& list, const std::atomic<bool>& done) {
+    List::VerifyState state;
+    while (!done.load())
+        check(list.verify(state, 64) != VerifyResult::kCorrupt, "incremental verify failed");
+}
+
+void tail(ChangeLog<int, int>& log, const std::atomic<bool>& done) {
+    auto cursor = log.oldest();
+    std::vector<ChangeRecord<int, int>> records;
+    uint64_t last = 0;
+    while (!done.load()) {
+        records.clear();
+        cursor.poll(records, 128);
+        for (const auto& record : records) {
+            check(record.sequence_ > last, "change log went backwards");
+            check(!record.value_ || *record.value_ == record.key_ * 2,
+                  "change log recorded a wrong value");
+            last = record.sequence_;
+        }
+    }
+}
+
+void stress() {
+    List list(16, 1);
+    ChangeLog<int, int> log(list, 1024);
+    std::atomic<bool> done{false};
+    std::thread reconfigurer(reconfigure, std::ref(list), std::cref(done));
+    std::thread verifier(verify_continuously, std::ref(list), std::cref(done));
+    std::thread tailer(tail, std::ref(log), std::cref(done));
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < kWorkers; ++i) workers.emplace_back(work, std::ref(list), i + 100);
+    for (auto& worker : workers) worker.join();
+    done.store(true);
+    reconfigurer.join();
+    verifier.join();
+    tailer.join();
+
+    check(list.verify(), "verify failed");
+    size_t count = 0;
+    list.for_each([&count](const int&, const int&) { ++count; });
+    check(count == list.size(), "size does not match the level-0 length");
+}
+
+void linearizability() {
+    for (unsigned round = 0; round < 20; ++round) {
+        List list(8, round);
+        HistoryRecorder<int, int> recorder(list);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 3; ++t) {
+            threads.emplace_back([&recorder, t, round] {
+                std::mt19937 gen(round * 31 + t);
+                for (int i = 0; i < 40; ++i) {
+                    int key = static_cast<int>(gen() % 3);
+                    switch (gen() % 4) {
+                        case 0:
+                            recorder.put(key, static_cast<int>(gen() % 8));
+                            break;
+                        case 1:
+                            recorder.get(key);
+                            break;
+                        case 2:
+                            recorder.remove(key);
+                            break;
+                        case 3:
+                            recorder.contains(key);
+                            break;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        check(momu::skip_list::is_linearizable(recorder.history()), "history not linearizable");
+    }
+}
+
+}  // namespace
+
+int main() {
+    stress();
+    linearizability();
+    std::printf("skip_list_stress: ok\n");
+    return 0;
+}
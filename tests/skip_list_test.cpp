@@ -0,0 +1,162 @@
+// SkipList set operations against std::map, including an out list that
+// aliases lhs or rhs, which used to lock the same mutex twice, and two
+// operations on other threads whose inputs and outputs cross. The alarm
+// turns a deadlock into a failure.
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <thread>
+
+#include "skip_list.h"
+
+namespace {
+
+using List = momu::skip_list::SkipList<int, int>;
+using Map = std::map<int, int>;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "skip_list_test: %s\n", what);
+    std::abort();
+}
+
+Map contents(List& list) {
+    Map out;
+    list.for_each([&out](const int& key, const int& value) { out[key] = value; });
+    return out;
+}
+
+void fill(List& list, Map& oracle, std::mt19937& gen, int entries, int salt) {
+    for (int i = 0; i < entries; ++i) {
+        int key = static_cast<int>(gen() % 3000);
+        list.put(key, key * 10 + salt);
+        oracle[key] = key * 10 + salt;
+    }
+}
+
+// The results are put into out over whatever it already holds, with lhs's
+// value for keys in both inputs.
+Map expected_intersection(const Map& lhs, const Map& rhs, Map out) {
+    for (const auto& [key, value] : lhs) {
+        if (rhs.count(key)) out[key] = value;
+    }
+    return out;
+}
+
+Map expected_union(const Map& lhs, const Map& rhs, Map out) {
+    for (const auto& [key, value] : rhs) out[key] = value;
+    for (const auto& [key, value] : lhs) out[key] = value;
+    return out;
+}
+
+Map expected_difference(const Map& lhs, const Map& rhs, Map out) {
+    for (const auto& [key, value] : lhs) {
+        if (!rhs.count(key)) out[key] = value;
+    }
+    return out;
+}
+
+enum class Op { kIntersection, kUnion, kDifference };
+
+void apply(Op op, List& lhs, List& rhs, List& out) {
+    switch (op) {
+        case Op::kIntersection:
+            set_intersection(lhs, rhs, out);
+            break;
+        case Op::kUnion:
+            set_union(lhs, rhs, out);
+            break;
+        case Op::kDifference:
+            set_difference(lhs, rhs, out);
+            break;
+    }
+}
+
+Map expected(Op op, const Map& lhs, const Map& rhs, const Map& out) {
+    switch (op) {
+        case Op::kIntersection:
+            return expected_intersection(lhs, rhs, out);
+        case Op::kUnion:
+            return expected_union(lhs, rhs, out);
+        default:
+            return expected_difference(lhs, rhs, out);
+    }
+}
+
+// out is a third list (empty or not), lhs, rhs, or lhs == rhs.
+void set_ops(unsigned seed) {
+    enum Target { kThird, kLhs, kRhs, kSelf };
+    for (Op op : {Op::kIntersection, Op::kUnion, Op::kDifference}) {
+        for (Target target : {kThird, kLhs, kRhs, kSelf}) {
+            std::mt19937 gen(seed);
+            List a(10, seed), b(10, seed + 1), c(10, seed + 2);
+            Map ma, mb, mc;
+            fill(a, ma, gen, 1500, 1);
+            fill(b, mb, gen, 400, 2);
+            fill(c, mc, gen, 50, 3);
+
+            switch (target) {
+                case kThird:
+                    apply(op, a, b, c);
+                    check(contents(c) == expected(op, ma, mb, mc), "set op into a third list");
+                    check(contents(a) == ma && contents(b) == mb, "set op changed its inputs");
+                    break;
+                case kLhs:
+                    apply(op, a, b, a);
+                    check(contents(a) == expected(op, ma, mb, ma), "set op into lhs");
+                    check(contents(b) == mb, "set op into lhs changed rhs");
+                    break;
+                case kRhs:
+                    apply(op, a, b, b);
+                    check(contents(b) == expected(op, ma, mb, mb), "set op into rhs");
+                    check(contents(a) == ma, "set op into rhs changed lhs");
+                    break;
+                case kSelf:
+                    apply(op, a, a, a);
+                    check(contents(a) == expected(op, ma, ma, ma), "set op of a list with itself");
+                    break;
+            }
+            check(a.verify() && b.verify() && c.verify(), "set op broke a list's invariants");
+        }
+    }
+}
+
+// Each operation writes into the other's input, so holding the inputs'
+// locks while writing out would let the two deadlock.
+void crossed(unsigned seed) {
+    std::mt19937 gen(seed);
+    List a(10, seed), b(10, seed + 1), c(10, seed + 2), d(10, seed + 3);
+    Map ma, mb, mc, md;
+    fill(a, ma, gen, 300, 1);
+    fill(b, mb, gen, 300, 2);
+    fill(c, mc, gen, 300, 3);
+    fill(d, md, gen, 300, 4);
+    std::thread first([&] {
+        for (int i = 0; i < 50; ++i) set_union(a, b, c);
+    });
+    std::thread second([&] {
+        for (int i = 0; i < 50; ++i) set_union(c, d, a);
+    });
+    first.join();
+    second.join();
+    Map all = expected_union(expected_union(ma, mb, mc), md, {});
+    for (const auto& [key, value] : contents(a))
+        check(all.count(key) > 0, "crossed set ops invented a key");
+    check(a.verify() && c.verify(), "crossed set ops broke a list's invariants");
+}
+
+}  // namespace
+
+int main() {
+    alarm(120);
+    for (unsigned seed = 1; seed <= 5; ++seed) {
+        set_ops(seed);
+        crossed(seed);
+    }
+    std::printf("skip_list_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,127 @@
+// UnrolledSkipList against std::map. Small nodes make every few puts split
+// a full node and every few removes leave one underfull, so it absorbs its
+// successor; each phase then checks every key, including keys that moved
+// between nodes and the node minimums the towers are keyed by.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "unrolled_skip_list.h"
+
+namespace {
+
+using momu::skip_list::UnrolledSkipList;
+
+void check(bool ok, const char* what) {
+    if (ok) return;
+    std::fprintf(stderr, "unrolled_skip_list_test: %s\n", what);
+    std::abort();
+}
+
+template <size_t N>
+void check_all(UnrolledSkipList<int, std::string, N>& list,
+               const std::map<int, std::string>& oracle, int universe) {
+    check(list.size() == oracle.size(), "size disagrees with the oracle");
+    for (int key = -1; key <= universe; ++key) {
+        auto it = oracle.find(key);
+        auto value = list.get(key);
+        check(value.has_value() == (it != oracle.end()), "get found the wrong keys");
+        if (value) check(*value == it->second, "get returned the wrong value");
+        check(list.contains(key) == value.has_value(), "contains disagrees with get");
+    }
+}
+
+template <size_t N>
+void split_and_merge(const std::vector<int>& fill_order, unsigned seed) {
+    const int universe = static_cast<int>(fill_order.size());
+    UnrolledSkipList<int, std::string, N> list(8, seed);
+    std::map<int, std::string> oracle;
+
+    // Every put into a full node splits it.
+    for (int key : fill_order) {
+        list.put(key, std::to_string(key));
+        oracle[key] = std::to_string(key);
+    }
+    check_all(list, oracle, universe);
+
+    // Overwrites stay in place.
+    for (int key = 0; key < universe; key += 7) {
+        list.put(key, "x" + std::to_string(key));
+        oracle[key] = "x" + std::to_string(key);
+    }
+    check_all(list, oracle, universe);
+
+    // Thinning leaves nodes underfull, so they absorb their successors;
+    // removing node minimums shifts the keys the towers are ordered by.
+    for (int key = 0; key < universe; ++key) {
+        if (key % 4 == 0) continue;
+        check(list.remove(key), "remove missed a live key");
+        oracle.erase(key);
+    }
+    check(!list.remove(1), "remove found a removed key");
+    check_all(list, oracle, universe);
+
+    // Refill the gaps between merged entries, splitting the merged nodes.
+    for (int key = universe - 1; key >= 0; key -= 2) {
+        list.put(key, std::to_string(key));
+        oracle[key] = std::to_string(key);
+    }
+    check_all(list, oracle, universe);
+
+    // Drain everything, then reuse the list.
+    for (int key : fill_order) {
+        check(list.remove(key) == (oracle.erase(key) > 0), "drain disagrees");
+    }
+    check(list.empty(), "list should be empty after draining");
+    list.put(3, "3");
+    oracle[3] = "3";
+    check_all(list, oracle, universe);
+}
+
+template <size_t N>
+void random_ops(unsigned seed) {
+    std::mt19937 gen(seed);
+    UnrolledSkipList<int, std::string, N> list(8, seed);
+    std::map<int, std::string> oracle;
+    const int universe = 300;
+    for (int i = 0; i < 20000; ++i) {
+        int key = static_cast<int>(gen() % universe);
+        if (gen() % 3) {
+            list.put(key, std::to_string(i));
+            oracle[key] = std::to_string(i);
+        } else {
+            check(list.remove(key) == (oracle.erase(key) > 0), "remove disagrees");
+        }
+        if (i % 2000 == 0) check_all(list, oracle, universe);
+    }
+    check_all(list, oracle, universe);
+}
+
+template <size_t N>
+void run(unsigned seed) {
+    std::vector<int> order(500);
+    for (int i = 0; i < 500; ++i) order[i] = i;
+    split_and_merge<N>(order, seed);
+    std::reverse(order.begin(), order.end());
+    split_and_merge<N>(order, seed);
+    std::shuffle(order.begin(), order.end(), std::mt19937(seed));
+    split_and_merge<N>(order, seed);
+    random_ops<N>(seed);
+}
+
+}  // namespace
+
+int main() {
+    for (unsigned seed = 1; seed <= 4; ++seed) {
+        run<4>(seed);
+        run<5>(seed);
+        run<16>(seed);
+    }
+    std::printf("unrolled_skip_list_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,248 @@
+#ifndef MOMU_UNROLLED_SKIP_LIST_H
+#define MOMU_UNROLLED_SKIP_LIST_H
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace momu {
+namespace skip_list {
+
+// Holds up to N sorted entries; the towers are keyed by keys_[0].
+template <typename K, typename V, size_t N>
+struct UnrolledNode {
+    explicit UnrolledNode(uint8_t level) : forward_(level + 1) {}
+
+    UnrolledNode(const UnrolledNode&) = delete;
+    UnrolledNode& operator=(const UnrolledNode&) = delete;
+
+    const K& min_key() const { return keys_[0]; }
+
+    size_t lower_bound(const K& key) const {
+        return std::lower_bound(keys_.begin(), keys_.begin() + count_, key) -
+               keys_.begin();
+    }
+
+    bool holds_at(size_t pos, const K& key) const {
+        return pos < count_ && keys_[pos] == key;
+    }
+
+    std::array<K, N> keys_;
+    std::array<V, N> values_;
+    size_t count_{0};
+    std::vector<std::shared_ptr<UnrolledNode>> forward_;
+};
+
+template <typename K, typename V, size_t N = 16>
+class UnrolledSkipList {
+    static_assert(N >= 4, "nodes must hold at least four entries");
+
+   public:
+    explicit UnrolledSkipList(uint8_t max_level,
+                              unsigned int seed = std::random_device{}())
+        : max_level_(max_level),
+          header_(std::make_unique<NodeT>(max_level_)),
+          gen_(seed),
+          distribution_(0.5) {}
+
+    UnrolledSkipList(const UnrolledSkipList&) = delete;
+    UnrolledSkipList& operator=(const UnrolledSkipList&) = delete;
+
+    void put(const K& key, const V& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto preds = find_predecessors(key);
+        auto* nxt = preds[0]->forward_[0].get();
+        auto* node = preds[0];
+        if (node == header_.get() || (nxt && nxt->min_key() == key)) node = nxt;
+        if (!node) {
+            insert_new_node(key, value, preds);
+            return;
+        }
+
+        size_t pos = node->lower_bound(key);
+        if (node->holds_at(pos, key)) {
+            node->values_[pos] = value;
+            return;
+        }
+        if (node->count_ == N) {
+            auto* upper = split_node(node);
+            if (!(key < upper->min_key())) {
+                node = upper;
+                pos = node->lower_bound(key);
+            }
+        }
+        insert_into_node(node, pos, key, value);
+    }
+
+    std::optional<V> get(const K& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto* node = find_candidate(key);
+        if (!node) return std::nullopt;
+        size_t pos = node->lower_bound(key);
+        if (!node->holds_at(pos, key)) return std::nullopt;
+        return node->values_[pos];
+    }
+
+    bool contains(const K& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto* node = find_candidate(key);
+        return node && node->holds_at(node->lower_bound(key), key);
+    }
+
+    bool remove(const K& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto preds = find_predecessors(key);
+        auto* nxt = preds[0]->forward_[0].get();
+        auto* node = (nxt && nxt->min_key() == key) ? nxt : preds[0];
+        if (node == header_.get()) return false;
+
+        size_t pos = node->lower_bound(key);
+        if (!node->holds_at(pos, key)) return false;
+        erase_from_node(node, pos);
+
+        if (node->count_ == 0)
+            unlink_node(node, preds);
+        else
+            absorb_next_on_underflow(node);
+        adjust_max_level();
+        return true;
+    }
+
+    size_t size() const { return element_count_; }
+    bool empty() const { return element_count_ == 0; }
+
+   private:
+    using NodeT = UnrolledNode<K, V, N>;
+    using PredVec = std::vector<NodeT*>;
+
+    // Same descent as SkipList::traverse_to_level_zero, but it stops at the
+    // last node whose smallest key does not exceed key; the entry itself is
+    // then located by binary search inside that node.
+    NodeT* find_candidate(const K& key) {
+        NodeT* cur = header_.get();
+        for (int i = current_max_level_; i >= 0; --i) {
+            while (cur->forward_[i] && !(key < cur->forward_[i]->min_key()))
+                cur = cur->forward_[i].get();
+        }
+        return cur == header_.get() ? nullptr : cur;
+    }
+
+    PredVec find_predecessors(const K& key) {
+        PredVec preds(max_level_ + 1, nullptr);
+        NodeT* cur = header_.get();
+        for (int i = current_max_level_; i >= 0; --i) {
+            while (cur->forward_[i] && cur->forward_[i]->min_key() < key)
+                cur = cur->forward_[i].get();
+            preds[i] = cur;
+        }
+        return preds;
+    }
+
+    void insert_into_node(NodeT* node, size_t pos, const K& key, const V& value) {
+        std::move_backward(node->keys_.begin() + pos,
+                           node->keys_.begin() + node->count_,
+                           node->keys_.begin() + node->count_ + 1);
+        std::move_backward(node->values_.begin() + pos,
+                           node->values_.begin() + node->count_,
+                           node->values_.begin() + node->count_ + 1);
+        node->keys_[pos] = key;
+        node->values_[pos] = value;
+        ++node->count_;
+        ++element_count_;
+    }
+
+    void erase_from_node(NodeT* node, size_t pos) {
+        std::move(node->keys_.begin() + pos + 1, node->keys_.begin() + node->count_,
+                  node->keys_.begin() + pos);
+        std::move(node->values_.begin() + pos + 1,
+                  node->values_.begin() + node->count_,
+                  node->values_.begin() + pos);
+        --node->count_;
+        --element_count_;
+    }
+
+    void insert_new_node(const K& key, const V& value, PredVec preds) {
+        auto* node = link_new_node(preds);
+        insert_into_node(node, 0, key, value);
+    }
+
+    NodeT* link_new_node(PredVec& preds) {
+        uint8_t lvl = generate_random_level();
+        if (lvl > current_max_level_) {
+            for (uint8_t i = current_max_level_ + 1; i <= lvl; ++i)
+                preds[i] = header_.get();
+            current_max_level_ = lvl;
+        }
+
+        auto node = std::make_shared<NodeT>(lvl);
+        for (uint8_t i = 0; i <= lvl; ++i) {
+            node->forward_[i] = preds[i]->forward_[i];
+            preds[i]->forward_[i] = node;
+        }
+        return node.get();
+    }
+
+    // Moves the upper half of a full node into a new node linked right
+    // after it and returns the new node.
+    NodeT* split_node(NodeT* node) {
+        constexpr size_t half = N / 2;
+        auto preds = find_predecessors(node->keys_[half]);
+        auto* upper = link_new_node(preds);
+        std::move(node->keys_.begin() + half, node->keys_.end(),
+                  upper->keys_.begin());
+        std::move(node->values_.begin() + half, node->values_.end(),
+                  upper->values_.begin());
+        upper->count_ = N - half;
+        node->count_ = half;
+        return upper;
+    }
+
+    void absorb_next_on_underflow(NodeT* node) {
+        auto* nxt = node->forward_[0].get();
+        if (!nxt || node->count_ >= N / 4 || node->count_ + nxt->count_ > N)
+            return;
+        auto preds = find_predecessors(nxt->min_key());
+        std::move(nxt->keys_.begin(), nxt->keys_.begin() + nxt->count_,
+                  node->keys_.begin() + node->count_);
+        std::move(nxt->values_.begin(), nxt->values_.begin() + nxt->count_,
+                  node->values_.begin() + node->count_);
+        node->count_ += nxt->count_;
+        unlink_node(nxt, preds);
+    }
+
+    void unlink_node(NodeT* node, const PredVec& preds) {
+        for (uint8_t i = 0; i <= current_max_level_; ++i) {
+            if (preds[i]->forward_[i].get() == node)
+                preds[i]->forward_[i] = node->forward_[i];
+        }
+    }
+
+    void adjust_max_level() {
+        while (current_max_level_ > 0 && !header_->forward_[current_max_level_])
+            --current_max_level_;
+    }
+
+    uint8_t generate_random_level() {
+        uint8_t lvl = 0;
+        while (distribution_(gen_) && lvl < max_level_) ++lvl;
+        return lvl;
+    }
+
+    uint8_t max_level_;
+    uint8_t current_max_level_{0};
+    std::unique_ptr<NodeT> header_;
+    size_t element_count_{0};
+
+    mutable std::mutex mutex_;
+    std::mt19937 gen_;
+    std::bernoulli_distribution distribution_;
+};
+
+}  // namespace skip_list
+}  // namespace momu
+
+#endif  // MOMU_UNROLLED_SKIP_LIST_H